@@ -0,0 +1,118 @@
+/**
+ * @file bench_utils.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The shared helpers of the benchmark suite: test images, allocation counting and throughput counters.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef BENCH_BENCH_UTILS_HPP
+#define BENCH_BENCH_UTILS_HPP
+
+#include <cstddef>
+#include <string>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief A class to count the heap and cv::Mat allocations made since its construction.
+ * 
+ * The heap allocations are counted by the global operator new of the benchmark executable and the cv::Mat buffers
+ * by the default allocator of OpenCV, so both are counted on every thread.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class AllocationCounter
+{
+private:
+    size_t heap_allocations_; //!< The number of heap allocations at construction.
+    size_t mat_allocations_;  //!< The number of cv::Mat allocations at construction.
+
+public:
+    /**
+     * @brief Construct a new AllocationCounter object and start counting.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    AllocationCounter();
+
+    /**
+     * @brief Destroy the AllocationCounter object.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~AllocationCounter();
+
+    /**
+     * @brief Get the number of heap allocations made since the construction.
+     * 
+     * @return The number of heap allocations.
+     * @since 0.0.2
+     */
+    size_t heap_allocations() const;
+
+    /**
+     * @brief Get the number of cv::Mat allocations made since the construction.
+     * 
+     * @return The number of cv::Mat allocations, always 0 before OpenCV 3.
+     * @since 0.0.2
+     */
+    size_t mat_allocations() const;
+};
+
+/**
+ * @brief Install the counting cv::Mat allocator as the default allocator of OpenCV.
+ * 
+ * @since 0.0.2
+ * 
+ */
+void install_allocation_counter();
+
+/**
+ * @brief Make a reproducible synthetic image with smooth gradients, filled shapes, lines and noise.
+ * 
+ * @param[in] size The size of the image.
+ * @param[in] type The type of the image, CV_8UC1 or CV_8UC3.
+ * @return The synthetic image, the same for the same size and type.
+ * @since 0.0.2
+ */
+cv::Mat make_synthetic_image(const cv::Size& size, const int& type);
+
+/**
+ * @brief Read a sample image of the repository.
+ * 
+ * @param[in] path The path of the image relative to the root of the repository.
+ * @param[in] flags The cv::imread flags.
+ * @return The image, empty if it cannot be read.
+ * @since 0.0.2
+ */
+cv::Mat read_sample_image(const std::string& path, const int& flags);
+
+/**
+ * @brief Add the image sizes of the synthetic benchmarks as the arguments of a benchmark.
+ * 
+ * @param[in,out] benchmark The benchmark.
+ * @since 0.0.2
+ */
+void add_image_sizes(benchmark::internal::Benchmark* benchmark);
+
+/**
+ * @brief Report the throughput and the allocations of a benchmark run.
+ * 
+ * The counters are MPix/s, ns/pixel, allocs/call for the heap allocations and mat_allocs/call for the cv::Mat
+ * allocations.
+ * 
+ * @param[in,out] state The state of the benchmark run.
+ * @param[in] pixels_per_call The number of pixels processed per iteration.
+ * @param[in] allocations The allocation counter started before the iterations.
+ * @since 0.0.2
+ */
+void set_pixel_counters(benchmark::State& state, const double& pixels_per_call, const AllocationCounter& allocations);
+
+#endif // BENCH_BENCH_UTILS_HPP
@@ -0,0 +1,193 @@
+/**
+ * @file bench_utils.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The shared helpers of the benchmark suite: test images, allocation counting and throughput counters.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "bench/bench_utils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+/**
+ * @brief The seed of the synthetic images.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const uint64 SYNTHETIC_SEED = 0x2015;
+
+static std::atomic<size_t> heap_allocation_count(0); //!< The number of heap allocations made by the process.
+static std::atomic<size_t> mat_allocation_count(0);  //!< The number of cv::Mat buffers allocated by the process.
+
+void* operator new(size_t size)
+{
+    heap_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = std::malloc(size > 0 ? size : 1);
+    if (pointer == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+#if CV_VERSION_MAJOR >= 3
+
+#if CV_VERSION_MAJOR >= 4
+typedef cv::AccessFlag AccessFlags;
+#else
+typedef int AccessFlags;
+#endif
+
+/**
+ * @brief A cv::Mat allocator that counts the buffers and delegates them to the standard allocator.
+ * 
+ * The buffers keep the standard allocator as their allocator, so they are released without going through this one.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           AccessFlags flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        if (data == nullptr)
+        {
+            mat_allocation_count.fetch_add(1, std::memory_order_relaxed);
+        }
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+
+    bool allocate(cv::UMatData* data, AccessFlags flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(data, flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData* data) const override
+    {
+        cv::Mat::getStdAllocator()->deallocate(data);
+    }
+};
+
+#endif
+
+AllocationCounter::AllocationCounter()
+    : heap_allocations_(heap_allocation_count.load(std::memory_order_relaxed)),
+      mat_allocations_(mat_allocation_count.load(std::memory_order_relaxed))
+{
+}
+
+AllocationCounter::~AllocationCounter()
+{
+}
+
+size_t AllocationCounter::heap_allocations() const
+{
+    return heap_allocation_count.load(std::memory_order_relaxed) - heap_allocations_;
+}
+
+size_t AllocationCounter::mat_allocations() const
+{
+    return mat_allocation_count.load(std::memory_order_relaxed) - mat_allocations_;
+}
+
+void install_allocation_counter()
+{
+#if CV_VERSION_MAJOR >= 3
+    static CountingMatAllocator allocator;
+    cv::Mat::setDefaultAllocator(&allocator);
+#endif
+}
+
+cv::Mat make_synthetic_image(const cv::Size& size, const int& type)
+{
+    CV_Assert(type == CV_8UC1 || type == CV_8UC3);
+    cv::RNG rng(SYNTHETIC_SEED);
+
+    // A smooth background, so the flat regions are not perfectly flat
+    cv::Mat image(size, CV_8UC3);
+    for (int row_index = 0; row_index < image.rows; ++row_index)
+    {
+        uchar* image_row = image.ptr<uchar>(row_index);
+        for (int column_index = 0; column_index < image.cols; ++column_index)
+        {
+            image_row[3 * column_index] = (uchar)(255 * column_index / std::max(image.cols - 1, 1));
+            image_row[3 * column_index + 1] = (uchar)(255 * row_index / std::max(image.rows - 1, 1));
+            image_row[3 * column_index + 2] = 128;
+        }
+    }
+
+    // Filled shapes give regions to segment and straight lines give lines to detect, all relative to the size
+    int scale = std::max(std::min(size.width, size.height), 1);
+    for (int i = 0; i < 24; ++i)
+    {
+        cv::Point corner(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::Point extent(rng.uniform(scale / 16, scale / 4 + 1), rng.uniform(scale / 16, scale / 4 + 1));
+        cv::Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2 == 0)
+        {
+            cv::rectangle(image, corner, corner + extent, color, -1);
+        }
+        else
+        {
+            cv::circle(image, corner, extent.x / 2, color, -1);
+        }
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        cv::Point start(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::Point end(rng.uniform(0, size.width), rng.uniform(0, size.height));
+        cv::line(image, start, end, cv::Scalar(255, 255, 255), std::max(scale / 240, 1));
+    }
+
+    // Sensor-like noise
+    cv::Mat noise(size, CV_8UC3);
+    rng.fill(noise, cv::RNG::UNIFORM, 0, 12);
+    cv::add(image, noise, image);
+
+    if (type == CV_8UC1)
+    {
+        cv::cvtColor(image, image, cv::COLOR_BGR2GRAY);
+    }
+    return image;
+}
+
+cv::Mat read_sample_image(const std::string& path, const int& flags)
+{
+    return cv::imread(std::string(CVBASIC_SOURCE_DIR) + "/" + path, flags);
+}
+
+void add_image_sizes(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"width", "height"});
+    benchmark->Args({640, 480});
+    benchmark->Args({1280, 720});
+    benchmark->Args({1920, 1080});
+}
+
+void set_pixel_counters(benchmark::State& state, const double& pixels_per_call, const AllocationCounter& allocations)
+{
+    double iterations = (double)state.iterations();
+    double pixels = pixels_per_call * iterations;
+    state.counters["MPix/s"] = benchmark::Counter(pixels / 1e6, benchmark::Counter::kIsRate);
+    state.counters["ns/pixel"] = benchmark::Counter(
+        pixels / 1e9, benchmark::Counter::Flags(benchmark::Counter::kIsRate | benchmark::Counter::kInvert));
+    state.counters["allocs/call"] = benchmark::Counter(allocations.heap_allocations() / std::max(iterations, 1.0));
+    state.counters["mat_allocs/call"] = benchmark::Counter(allocations.mat_allocations() / std::max(iterations, 1.0));
+}
@@ -0,0 +1,116 @@
+/**
+ * @file buffer_pool_bench.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The benchmarks of the pooled frame buffers against the standard allocator of OpenCV.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "bench/bench_utils.hpp"
+#include "buffer_pool/buffer_pool.hpp"
+#include "canny_edge_detection/canny_edge_detection.hpp"
+
+/**
+ * @brief Add the image sizes and the allocators of the buffer pool benchmarks.
+ * 
+ * @param[in,out] benchmark The benchmark.
+ * @since 0.0.2
+ */
+static void add_buffer_pool_arguments(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"width", "height", "pooled"});
+    for (int pooled = 0; pooled <= 1; ++pooled)
+    {
+        benchmark->Args({640, 480, pooled});
+        benchmark->Args({1920, 1080, pooled});
+    }
+}
+
+/**
+ * @brief Report the hit rate of the buffer pool during a benchmark run.
+ * 
+ * @param[in,out] state The state of the benchmark run.
+ * @param[in] before The statistics of the pool before the iterations.
+ * @since 0.0.2
+ */
+static void set_buffer_pool_counters(benchmark::State& state, const BufferPoolStatistics& before)
+{
+    BufferPoolStatistics after = get_buffer_pool_statistics();
+    uint64_t requests = after.requests - before.requests;
+    state.counters["hit_rate"] = requests > 0 ? (double)(after.hits - before.hits) / requests : 0;
+    state.counters["peak_rss_mib"] = after.peak_rss / 1048576.0;
+}
+
+/**
+ * @brief Benchmark the allocation, the first write and the release of a color frame.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size and whether the frame comes
+ * from the buffer pool.
+ * @since 0.0.2
+ */
+static void BM_FrameAllocation(benchmark::State& state)
+{
+    cv::Size size(state.range(0), state.range(1));
+    cv::MatAllocator* allocator = state.range(2) != 0 ? get_buffer_pool() : nullptr;
+    if (state.range(2) != 0 && allocator == nullptr)
+    {
+        state.SkipWithError("The buffer pool needs OpenCV 3 or later");
+        return;
+    }
+    BufferPoolStatistics before = get_buffer_pool_statistics();
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        // The write touches every page, so a fresh buffer pays for its page faults
+        cv::Mat frame;
+        frame.allocator = allocator;
+        frame.create(size, CV_8UC3);
+        frame.setTo(cv::Scalar::all(0));
+        benchmark::DoNotOptimize(frame.data);
+    }
+    set_pixel_counters(state, size.area(), allocations);
+    set_buffer_pool_counters(state, before);
+}
+BENCHMARK(BM_FrameAllocation)->Apply(add_buffer_pool_arguments);
+
+/**
+ * @brief Benchmark the Canny edge detection with its intermediate images from the standard allocator or the pool.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size and whether the images come
+ * from the buffer pool.
+ * @since 0.0.2
+ */
+static void BM_CannyEdgeDetectionPooled(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1);
+    if (state.range(2) != 0 && get_buffer_pool() == nullptr)
+    {
+        state.SkipWithError("The buffer pool needs OpenCV 3 or later");
+        return;
+    }
+
+    // The default allocator is only swapped for this run, the other benchmarks keep the counting allocator
+#if CV_VERSION_MAJOR >= 3
+    cv::MatAllocator* default_allocator = cv::Mat::getDefaultAllocator();
+    if (state.range(2) != 0)
+    {
+        cv::Mat::setDefaultAllocator(get_buffer_pool());
+    }
+#endif
+    BufferPoolStatistics before = get_buffer_pool_statistics();
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        cv::Mat output;
+        detect_edges(image, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+    set_buffer_pool_counters(state, before);
+#if CV_VERSION_MAJOR >= 3
+    cv::Mat::setDefaultAllocator(default_allocator);
+#endif
+}
+BENCHMARK(BM_CannyEdgeDetectionPooled)->Apply(add_buffer_pool_arguments)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,149 @@
+/**
+ * @file canny_edge_detection_bench.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The benchmarks of the Canny edge detection stages.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include "bench/bench_utils.hpp"
+#include "canny_edge_detection/canny_edge_detection.hpp"
+
+/**
+ * @brief Benchmark the Gaussian filter.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_GaussFilter(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        cv::Mat smoothed = gauss_filter(image);
+        benchmark::DoNotOptimize(smoothed.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_GaussFilter)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the Sobel gradient magnitude.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_GradientMagnitude(benchmark::State& state)
+{
+    cv::Mat smoothed = gauss_filter(make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1));
+    cv::Mat magnitude;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        get_gradient_magnitude(smoothed, magnitude);
+        benchmark::DoNotOptimize(magnitude.data);
+    }
+    set_pixel_counters(state, smoothed.total(), allocations);
+}
+BENCHMARK(BM_GradientMagnitude)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the non-maximum suppression, every iteration starts from the same gradient magnitude.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_NonMaximumSuppression(benchmark::State& state)
+{
+    cv::Mat smoothed = gauss_filter(make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1));
+    cv::Mat magnitude, suppressed;
+    get_gradient_magnitude(smoothed, magnitude);
+    magnitude.copyTo(suppressed);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        magnitude.copyTo(suppressed);
+        state.ResumeTiming();
+        suppress_non_maxima(smoothed, suppressed);
+        benchmark::DoNotOptimize(suppressed.data);
+    }
+    set_pixel_counters(state, smoothed.total(), allocations);
+}
+BENCHMARK(BM_NonMaximumSuppression)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the hysteresis thresholding, every iteration starts from the same suppressed magnitude.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_Hysteresis(benchmark::State& state)
+{
+    cv::Mat smoothed = gauss_filter(make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1));
+    cv::Mat suppressed, edges;
+    get_gradient_magnitude(smoothed, suppressed);
+    suppress_non_maxima(smoothed, suppressed);
+    suppressed.copyTo(edges);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        suppressed.copyTo(edges);
+        state.ResumeTiming();
+        apply_hysteresis(edges, 110, 80);
+        benchmark::DoNotOptimize(edges.data);
+    }
+    set_pixel_counters(state, smoothed.total(), allocations);
+}
+BENCHMARK(BM_Hysteresis)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the whole Canny edge detection on a synthetic image.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_CannyEdgeDetection(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1);
+    cv::Mat edges;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        detect_edges(image, edges);
+        benchmark::DoNotOptimize(edges.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_CannyEdgeDetection)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the whole Canny edge detection on a sample image.
+ * 
+ * @param[in,out] state The state of the benchmark run.
+ * @since 0.0.2
+ */
+static void BM_CannyEdgeDetectionSample(benchmark::State& state)
+{
+    cv::Mat image = read_sample_image("image_interpolation/build/00.png", cv::IMREAD_GRAYSCALE);
+    if (image.empty())
+    {
+        state.SkipWithError("The sample image cannot be read");
+        return;
+    }
+    cv::Mat edges;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        detect_edges(image, edges);
+        benchmark::DoNotOptimize(edges.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_CannyEdgeDetectionSample)->Unit(benchmark::kMillisecond);
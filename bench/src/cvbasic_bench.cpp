@@ -0,0 +1,41 @@
+/**
+ * @file cvbasic_bench.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The entry point of the benchmark suite.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <string>
+
+#include "bench/bench_utils.hpp"
+
+/**
+ * @brief The main function.
+ * 
+ * The benchmarks are registered by the other files of the suite. Pass --benchmark_out=<file> to also write the
+ * results as JSON.
+ * 
+ * @param[in] argc The argument count.
+ * @param[in] argv The argument vector.
+ * @return The status value.
+ * @since 0.0.2
+ */
+int main(int argc, char** argv)
+{
+    install_allocation_counter();
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    {
+        return 1;
+    }
+
+    // Record what the results depend on, so only comparable runs are compared
+    benchmark::AddCustomContext("opencv_version", CV_VERSION);
+    benchmark::AddCustomContext("opencv_threads", std::to_string(cv::getNumThreads()));
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file hough_line_bench.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The benchmarks of the Hough line detection.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "bench/bench_utils.hpp"
+#include "canny_edge_detection/canny_edge_detection.hpp"
+#include "hough_line/hough_line.hpp"
+
+/**
+ * @brief Benchmark the line detection on the edges of a synthetic image.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_HoughLine(benchmark::State& state)
+{
+    // The edge pixels of the Hough line detection are black
+    cv::Mat edges;
+    detect_edges(make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1), edges);
+    cv::threshold(edges, edges, 200, 255, cv::THRESH_BINARY_INV);
+    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        std::vector<Line> lines = hough_line.detect_lines(edges);
+        benchmark::DoNotOptimize(lines.data());
+    }
+    set_pixel_counters(state, edges.total(), allocations);
+    state.counters["edge_pixels"] = edges.total() - cv::countNonZero(edges);
+}
+BENCHMARK(BM_HoughLine)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the line detection on the sample edge image, like the hough_line executable.
+ * 
+ * @param[in,out] state The state of the benchmark run.
+ * @since 0.0.2
+ */
+static void BM_HoughLineSample(benchmark::State& state)
+{
+    cv::Mat edges = read_sample_image("hough_line/build/edges.png", cv::IMREAD_GRAYSCALE);
+    if (edges.empty())
+    {
+        state.SkipWithError("The sample image cannot be read");
+        return;
+    }
+    cv::threshold(edges, edges, 200, 255, cv::THRESH_BINARY);
+    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        std::vector<Line> lines = hough_line.detect_lines(edges);
+        benchmark::DoNotOptimize(lines.data());
+    }
+    set_pixel_counters(state, edges.total(), allocations);
+    state.counters["edge_pixels"] = edges.total() - cv::countNonZero(edges);
+}
+BENCHMARK(BM_HoughLineSample)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Add the image sizes and the voting modes of the sparse line detection benchmarks.
+ * 
+ * @param[in,out] benchmark The benchmark.
+ * @since 0.0.2
+ */
+static void add_line_detection_arguments(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"width", "height", "oriented"});
+    for (int oriented = 0; oriented <= 1; ++oriented)
+    {
+        benchmark->Args({640, 480, oriented});
+        benchmark->Args({1280, 720, oriented});
+        benchmark->Args({1920, 1080, oriented});
+    }
+}
+
+/**
+ * @brief Benchmark the line detection from a synthetic image through a dense edge image, as the baseline of the
+ * sparse line detection.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_DenseLineDetection(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1);
+    cv::Mat edges;
+    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        detect_edges(image, edges);
+        cv::threshold(edges, edges, 200, 255, cv::THRESH_BINARY_INV);
+        std::vector<Line> lines = hough_line.detect_lines(edges);
+        benchmark::DoNotOptimize(lines.data());
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_DenseLineDetection)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the line detection from a synthetic image through the list of edge pixels.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size and whether the votes are
+ * limited around the gradient orientations.
+ * @since 0.0.2
+ */
+static void BM_SparseLineDetection(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1);
+    bool oriented = state.range(2) != 0;
+    std::vector<cv::Point> points;
+    std::vector<float> orientations;
+    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        detect_edge_points(image, points, oriented ? &orientations : nullptr);
+        std::vector<Line> lines = oriented ? hough_line.detect_lines(points, orientations, image.size())
+                                           : hough_line.detect_lines(points, image.size());
+        benchmark::DoNotOptimize(lines.data());
+    }
+    set_pixel_counters(state, image.total(), allocations);
+    state.counters["edge_points"] = points.size();
+}
+BENCHMARK(BM_SparseLineDetection)->Apply(add_line_detection_arguments)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Vote for every theta in a 16-bit rho-major accumulator, the layout before the theta-major one.
+ * 
+ * @param[in] points The edge pixels, x is the column and y is the row.
+ * @param[in] size The size of the image the edge pixels belong to.
+ * @param[in] delta_theta The angle resolution of the accumulator in radians.
+ * @return The rho-major accumulator.
+ * @since 0.0.2
+ */
+static cv::Mat vote_rho_major(const std::vector<cv::Point>& points, const cv::Size& size, const float& delta_theta)
+{
+    int rho_index_max = std::round(sqrtf((float)size.height * size.height + (float)size.width * size.width));
+    int theta_index_max = std::round(2 * M_PI / delta_theta);
+    cv::Mat accumulator = cv::Mat::zeros(cv::Size(theta_index_max, rho_index_max), CV_16UC1);
+    ushort* accumulator_data = (ushort*)accumulator.data;
+    std::vector<float> cosines(theta_index_max), sines(theta_index_max);
+    for (int theta_index = 0; theta_index < theta_index_max; ++theta_index)
+    {
+        cosines[theta_index] = cos(theta_index * delta_theta);
+        sines[theta_index] = sin(theta_index * delta_theta);
+    }
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        for (int theta_index = 0; theta_index < theta_index_max; ++theta_index)
+        {
+            int rho = cvRound(points[i].x * cosines[theta_index] + points[i].y * sines[theta_index]);
+            if (rho >= 0)
+            {
+                ++accumulator_data[rho * accumulator.cols + theta_index];
+            }
+        }
+    }
+    return accumulator;
+}
+
+/**
+ * @brief Add the image sizes and the accumulator layouts of the voting benchmark, up to an accumulator larger than the
+ * L2 cache.
+ * 
+ * @param[in,out] benchmark The benchmark.
+ * @since 0.0.2
+ */
+static void add_accumulator_arguments(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"width", "height", "theta_major"});
+    for (int theta_major = 0; theta_major <= 1; ++theta_major)
+    {
+        benchmark->Args({640, 480, theta_major});
+        benchmark->Args({1280, 720, theta_major});
+        benchmark->Args({1920, 1080, theta_major});
+        benchmark->Args({3840, 2160, theta_major});
+    }
+}
+
+/**
+ * @brief Benchmark the voting of the edge pixels of a synthetic image for every theta, in the theta-major accumulator
+ * against the rho-major one.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size and the accumulator layout.
+ * @since 0.0.2
+ */
+static void BM_HoughVoting(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC1);
+    bool theta_major = state.range(2) != 0;
+    std::vector<cv::Point> points;
+    detect_edge_points(image, points);
+    float delta_theta = M_PI / 180;
+    HoughLine hough_line(delta_theta, 100, 10, M_PI / 18);
+    int depth = CV_16U;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        cv::Mat accumulator = theta_major ? hough_line.accumulate(points, image.size())
+                                          : vote_rho_major(points, image.size(), delta_theta);
+        depth = accumulator.depth();
+        benchmark::DoNotOptimize(accumulator.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+    double votes = (double)points.size() * std::round(2 * M_PI / delta_theta) * state.iterations();
+    state.counters["MVotes/s"] = benchmark::Counter(votes / 1e6, benchmark::Counter::kIsRate);
+    state.counters["edge_points"] = points.size();
+    state.counters["vote_bits"] = 8 * (int)CV_ELEM_SIZE(depth);
+}
+BENCHMARK(BM_HoughVoting)->Apply(add_accumulator_arguments)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,77 @@
+/**
+ * @file image_interpolation_bench.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The benchmarks of the image interpolation.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <opencv2/highgui/highgui.hpp>
+
+#include "bench/bench_utils.hpp"
+#include "image_interpolation/image_interpolation.hpp"
+
+/**
+ * @brief Add the interpolation methods as the argument of a benchmark.
+ * 
+ * @param[in,out] benchmark The benchmark.
+ * @since 0.0.2
+ */
+static void add_methods(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgName("method");
+    benchmark->Arg(NEAREST);
+    benchmark->Arg(BILINEAR);
+    benchmark->Arg(BICUBIC);
+}
+
+/**
+ * @brief Benchmark the 2x upscaling of a 640x480 synthetic color image, the throughput counts the output pixels.
+ * 
+ * @param[in,out] state The state of the benchmark run, the argument is the interpolation method.
+ * @since 0.0.2
+ */
+static void BM_ResizeImage(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(640, 480), CV_8UC3);
+    cv::Size size(2 * image.cols, 2 * image.rows);
+    Method method = (Method)state.range(0);
+    cv::Mat resized;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        resize_image(image, resized, size, method);
+        benchmark::DoNotOptimize(resized.data);
+    }
+    set_pixel_counters(state, size.area(), allocations);
+}
+BENCHMARK(BM_ResizeImage)->Apply(add_methods)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the 2x upscaling of a sample image, the throughput counts the output pixels.
+ * 
+ * @param[in,out] state The state of the benchmark run, the argument is the interpolation method.
+ * @since 0.0.2
+ */
+static void BM_ResizeImageSample(benchmark::State& state)
+{
+    cv::Mat image = read_sample_image("image_interpolation/build/00.png", cv::IMREAD_COLOR);
+    if (image.empty())
+    {
+        state.SkipWithError("The sample image cannot be read");
+        return;
+    }
+    cv::Size size(2 * image.cols, 2 * image.rows);
+    Method method = (Method)state.range(0);
+    cv::Mat resized;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        resize_image(image, resized, size, method);
+        benchmark::DoNotOptimize(resized.data);
+    }
+    set_pixel_counters(state, size.area(), allocations);
+}
+BENCHMARK(BM_ResizeImageSample)->Apply(add_methods)->Unit(benchmark::kMillisecond);
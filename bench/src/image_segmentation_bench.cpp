@@ -0,0 +1,274 @@
+/**
+ * @file image_segmentation_bench.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The benchmarks of the watershed and GrabCut segmentations and of their output stage.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "bench/bench_utils.hpp"
+#include "image_segmentation/grabcut.hpp"
+#include "image_segmentation/segmentation_output.hpp"
+#include "image_segmentation/watershed.hpp"
+
+/**
+ * @brief Seed a marker every 50 pixels, like the initial markers of the watershed segmentation.
+ * 
+ * @param[in] size The size of the image.
+ * @return The 32-bit single-channel seeds.
+ * @since 0.0.2
+ */
+static cv::Mat make_grid_seeds(const cv::Size& size)
+{
+    cv::Mat seeds = cv::Mat::zeros(size, CV_32SC1);
+    int number_of_seeds = 0;
+    for (int row_index = 0; row_index < seeds.rows; row_index += 50)
+    {
+        for (int column_index = 0; column_index < seeds.cols; column_index += 50)
+        {
+            seeds.at<int>(row_index, column_index) = ++number_of_seeds;
+        }
+    }
+    return seeds;
+}
+
+/**
+ * @brief Add the image sizes and the numbers of tiles of the watershed benchmarks.
+ * 
+ * @param[in,out] benchmark The benchmark.
+ * @since 0.0.2
+ */
+static void add_watershed_arguments(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->ArgNames({"width", "height", "tiles"});
+    int number_of_tiles = std::max(cv::getNumThreads(), 2);
+    benchmark->Args({640, 480, 1});
+    benchmark->Args({1920, 1080, 1});
+    benchmark->Args({1920, 1080, number_of_tiles});
+}
+
+/**
+ * @brief Benchmark the native watershed transform, every iteration starts from the same seeds.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size and the number of tiles.
+ * @since 0.0.2
+ */
+static void BM_Watershed(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC3);
+    cv::Mat seeds = make_grid_seeds(image.size());
+    cv::Mat markers = seeds.clone();
+    Watershed watershed(state.range(2));
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        seeds.copyTo(markers);
+        state.ResumeTiming();
+        watershed.segment(image, markers);
+        benchmark::DoNotOptimize(markers.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_Watershed)->Apply(add_watershed_arguments)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark cv::watershed as the baseline of the native watershed transform.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_OpenCVWatershed(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(state.range(0), state.range(1)), CV_8UC3);
+    cv::Mat seeds = make_grid_seeds(image.size());
+    cv::Mat markers = seeds.clone();
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        seeds.copyTo(markers);
+        state.ResumeTiming();
+        cv::watershed(image, markers);
+        benchmark::DoNotOptimize(markers.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_OpenCVWatershed)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the native watershed transform on a sample image.
+ * 
+ * @param[in,out] state The state of the benchmark run.
+ * @since 0.0.2
+ */
+static void BM_WatershedSample(benchmark::State& state)
+{
+    cv::Mat image = read_sample_image("image_segmentation/build/sample_images/00.jpg", cv::IMREAD_COLOR);
+    if (image.empty())
+    {
+        state.SkipWithError("The sample image cannot be read");
+        return;
+    }
+    cv::Mat seeds = make_grid_seeds(image.size());
+    cv::Mat markers = seeds.clone();
+    Watershed watershed;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        seeds.copyTo(markers);
+        state.ResumeTiming();
+        watershed.segment(image, markers);
+        benchmark::DoNotOptimize(markers.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_WatershedSample)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Segment a synthetic image with the watershed transform for the output benchmarks.
+ * 
+ * @param[in] size The size of the image.
+ * @param[out] image The 8-bit 3-channel synthetic image.
+ * @param[out] labels The 32-bit single-channel labels.
+ * @return The number of labels.
+ * @since 0.0.2
+ */
+static int make_labels(const cv::Size& size, cv::Mat& image, cv::Mat& labels)
+{
+    image = make_synthetic_image(size, CV_8UC3);
+    labels = make_grid_seeds(size);
+    Watershed watershed;
+    watershed.segment(image, labels);
+    double max_label;
+    cv::minMaxLoc(labels, nullptr, &max_label);
+    return (int)max_label;
+}
+
+/**
+ * @brief Benchmark the coloring of a label image.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_ColorLabels(benchmark::State& state)
+{
+    cv::Mat image, labels, output;
+    int number_of_labels = make_labels(cv::Size(state.range(0), state.range(1)), image, labels);
+    cv::RNG rng(0x2015);
+    std::vector<cv::Vec3b> colors = make_label_colors(number_of_labels, rng);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        color_labels(labels, colors, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+    set_pixel_counters(state, labels.total(), allocations);
+}
+BENCHMARK(BM_ColorLabels)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the alpha blend of the label colors over an image.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_BlendLabels(benchmark::State& state)
+{
+    cv::Mat image, labels, output;
+    int number_of_labels = make_labels(cv::Size(state.range(0), state.range(1)), image, labels);
+    cv::RNG rng(0x2015);
+    std::vector<cv::Vec3b> colors = make_label_colors(number_of_labels, rng);
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        blend_labels(image, labels, colors, 0.5f, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+    set_pixel_counters(state, labels.total(), allocations);
+}
+BENCHMARK(BM_BlendLabels)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the cutout of the pixels of one label.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_CutOut(benchmark::State& state)
+{
+    cv::Mat image, labels, mask, output;
+    make_labels(cv::Size(state.range(0), state.range(1)), image, labels);
+    mask = labels == 1;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        cut_out(image, mask, 255, output);
+        benchmark::DoNotOptimize(output.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_CutOut)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the run-length encoding and the serialization of a mask.
+ * 
+ * @param[in,out] state The state of the benchmark run, the arguments are the image size.
+ * @since 0.0.2
+ */
+static void BM_RunLengthMask(benchmark::State& state)
+{
+    cv::Mat image, labels, mask;
+    make_labels(cv::Size(state.range(0), state.range(1)), image, labels);
+    mask = labels == 1;
+    RunLengthMask encoded;
+    size_t size = 0;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        encode_run_length(mask, 255, encoded);
+        std::ostringstream stream;
+        size = write_run_length(encoded, stream);
+        benchmark::DoNotOptimize(size);
+    }
+    set_pixel_counters(state, mask.total(), allocations);
+    state.counters["bytes"] = size;
+}
+BENCHMARK(BM_RunLengthMask)->Apply(add_image_sizes)->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Benchmark the GrabCut segmentation from scratch of a centered rectangle of a 640x480 synthetic image.
+ * 
+ * @param[in,out] state The state of the benchmark run, the argument is the downscale factor of the coarse level.
+ * @since 0.0.2
+ */
+static void BM_GrabCut(benchmark::State& state)
+{
+    cv::Mat image = make_synthetic_image(cv::Size(640, 480), CV_8UC3);
+    cv::Mat initial_mask(image.size(), CV_8UC1, cv::Scalar(cv::GC_BGD));
+    initial_mask(cv::Rect(image.cols / 4, image.rows / 4, image.cols / 2, image.rows / 2)).setTo(cv::GC_PR_FGD);
+    cv::Mat mask = initial_mask.clone();
+    MultiResolutionGrabCut grabcut(state.range(0));
+    GrabCutModel model;
+    AllocationCounter allocations;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        initial_mask.copyTo(mask);
+        model.clear();
+        state.ResumeTiming();
+        grabcut.segment(image, mask, model);
+        benchmark::DoNotOptimize(mask.data);
+    }
+    set_pixel_counters(state, image.total(), allocations);
+}
+BENCHMARK(BM_GrabCut)->ArgName("scale")->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,91 @@
+/**
+ * @file buffer_pool.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The pool of frame buffers shared by the cv::Mat of every stage.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef BUFFER_POOL_BUFFER_POOL_HPP
+#define BUFFER_POOL_BUFFER_POOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief The statistics of the buffer pool.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct BufferPoolStatistics
+{
+    uint64_t requests;   //!< The buffers requested from the pool.
+    uint64_t hits;       //!< The requests served with a cached buffer.
+    uint64_t bypasses;   //!< The buffers too small to be pooled, allocated directly.
+    size_t cached_bytes; //!< The bytes of the buffers waiting in the pool.
+    size_t peak_bytes;   //!< The peak of the bytes allocated by the pool, in use or cached.
+    size_t peak_rss;     //!< The peak resident set size of the process in bytes, 0 if it is unknown.
+};
+
+/**
+ * @brief Get the pooled cv::Mat allocator.
+ * 
+ * The buffers are 64-byte aligned and cached in buckets of sizes a quarter of an octave apart. A freed buffer goes
+ * to a small cache of its thread first, so a thread that frees and allocates the same frames does not take a lock.
+ * 
+ * @return The allocator, null before OpenCV 3.
+ * @since 0.0.2
+ */
+cv::MatAllocator* get_buffer_pool();
+
+/**
+ * @brief Install the pooled allocator as the default allocator of OpenCV.
+ * 
+ * The tools install it at the start of their main function, so that the frame buffers of every stage are reused
+ * from one image to the next instead of being allocated again. Install it after start_instrumentation(), so that
+ * the allocation counter counts the buffers the pool gets from the system instead of every request.
+ * 
+ * @since 0.0.2
+ * 
+ */
+void install_buffer_pool();
+
+/**
+ * @brief Free the buffers cached by the pool and by the calling thread.
+ * 
+ * @since 0.0.2
+ * 
+ */
+void release_buffer_pool();
+
+/**
+ * @brief Get the statistics of the buffer pool.
+ * 
+ * @return The statistics.
+ * @since 0.0.2
+ */
+BufferPoolStatistics get_buffer_pool_statistics();
+
+/**
+ * @brief Write the hit rate, the cached and peak bytes of the pool and the peak RSS of the process as a line.
+ * 
+ * @param[in,out] stream The output stream.
+ * @since 0.0.2
+ */
+void write_buffer_pool_statistics(std::ostream& stream);
+
+/**
+ * @brief Get the peak resident set size of the process.
+ * 
+ * @return The peak resident set size in bytes, 0 if it is unknown.
+ * @since 0.0.2
+ */
+size_t get_peak_rss();
+
+#endif // BUFFER_POOL_BUFFER_POOL_HPP
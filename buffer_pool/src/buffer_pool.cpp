@@ -0,0 +1,442 @@
+/**
+ * @file buffer_pool.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The pool of frame buffers shared by the cv::Mat of every stage.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "buffer_pool/buffer_pool.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "instrumentation/instrumentation.hpp"
+
+static const size_t ALIGNMENT = 64;                         //!< The alignment of the buffers, a cache line.
+static const size_t MIN_POOLED_SIZE = 64 << 10;             //!< The size under which the buffers are not pooled.
+static const size_t MAX_CACHED_BYTES = (size_t)512 << 20;   //!< The bytes above which the freed buffers are released.
+static const size_t MAX_THREAD_CACHED_BUFFERS = 4;          //!< The buffers kept by every thread without a lock.
+
+/**
+ * @brief The buffers cached by the pool and its statistics.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct PoolState
+{
+    std::mutex mutex;                                           //!< The lock of the buffers.
+    std::unordered_map<size_t, std::vector<uchar*>> buffers;    //!< The cached buffers by bucket size.
+    std::atomic<uint64_t> requests;                             //!< The buffers requested.
+    std::atomic<uint64_t> hits;                                 //!< The requests served with a cached buffer.
+    std::atomic<uint64_t> bypasses;                             //!< The buffers too small to be pooled.
+    std::atomic<size_t> cached_bytes;                           //!< The bytes of the cached buffers.
+    std::atomic<size_t> allocated_bytes;                        //!< The bytes allocated, in use or cached.
+    std::atomic<size_t> peak_bytes;                             //!< The peak of the allocated bytes.
+
+    PoolState()
+        : requests(0), hits(0), bypasses(0), cached_bytes(0), allocated_bytes(0), peak_bytes(0)
+    {
+    }
+};
+
+/**
+ * @brief Get the state of the pool.
+ * 
+ * The state is never destroyed, so the cv::Mat released by the static destructors and by the exiting threads can
+ * still give their buffers back.
+ * 
+ * @return The state.
+ * @since 0.0.2
+ */
+static PoolState& get_state()
+{
+    static PoolState* state = new PoolState();
+    return *state;
+}
+
+/**
+ * @brief Allocate an aligned buffer from the system.
+ * 
+ * @param[in] size The size of the buffer in bytes.
+ * @return The buffer, the original pointer is stored just before it.
+ * @since 0.0.2
+ */
+static uchar* allocate_aligned(const size_t& size)
+{
+    uchar* original = (uchar*)std::malloc(size + ALIGNMENT + sizeof(void*));
+    if (original == nullptr)
+    {
+        CV_Error(cv::Error::StsNoMem, "The buffer pool cannot allocate a buffer");
+    }
+    uchar* buffer = cv::alignPtr(original + sizeof(void*), (int)ALIGNMENT);
+    ((void**)buffer)[-1] = original;
+    CVBASIC_COUNT(ALLOCATIONS, 1);
+    return buffer;
+}
+
+/**
+ * @brief Give an aligned buffer back to the system.
+ * 
+ * @param[in] buffer The buffer.
+ * @since 0.0.2
+ */
+static void free_aligned(uchar* buffer)
+{
+    std::free(((void**)buffer)[-1]);
+}
+
+/**
+ * @brief Get the size of the bucket of a buffer.
+ * 
+ * The buckets are a quarter of an octave apart, so a buffer wastes at most a fifth of its bucket.
+ * 
+ * @param[in] size The size of the buffer in bytes, at least MIN_POOLED_SIZE.
+ * @return The size of the bucket in bytes.
+ * @since 0.0.2
+ */
+static size_t get_bucket_size(const size_t& size)
+{
+    size_t octave = MIN_POOLED_SIZE;
+    while (octave <= size / 2)
+    {
+        octave *= 2;
+    }
+    size_t step = octave / 4;
+    return (size + step - 1) / step * step;
+}
+
+/**
+ * @brief Update the allocated bytes and their peak.
+ * 
+ * @param[in] size The number of bytes allocated.
+ * @since 0.0.2
+ */
+static void add_allocated_bytes(const size_t& size)
+{
+    PoolState& state = get_state();
+    size_t allocated_bytes = state.allocated_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak_bytes = state.peak_bytes.load(std::memory_order_relaxed);
+    while (allocated_bytes > peak_bytes &&
+           !state.peak_bytes.compare_exchange_weak(peak_bytes, allocated_bytes, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * @brief Give a buffer back to the shared buckets, or to the system when the pool is full.
+ * 
+ * @param[in] bucket_size The size of the bucket of the buffer.
+ * @param[in] buffer The buffer.
+ * @since 0.0.2
+ */
+static void give_shared_buffer(const size_t& bucket_size, uchar* buffer)
+{
+    PoolState& state = get_state();
+    if (state.cached_bytes.load(std::memory_order_relaxed) + bucket_size > MAX_CACHED_BYTES)
+    {
+        state.allocated_bytes.fetch_sub(bucket_size, std::memory_order_relaxed);
+        free_aligned(buffer);
+        return;
+    }
+    state.cached_bytes.fetch_add(bucket_size, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.buffers[bucket_size].push_back(buffer);
+}
+
+/**
+ * @brief The buffers kept by a thread, given back to the shared buckets when the thread exits.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct ThreadCache
+{
+    std::vector<std::pair<size_t, uchar*>> buffers; //!< The cached buffers with the sizes of their buckets.
+
+    ~ThreadCache();
+};
+
+static thread_local bool thread_cache_destroyed = false; //!< Whether the cache of the thread is already destroyed.
+
+ThreadCache::~ThreadCache()
+{
+    PoolState& state = get_state();
+    for (size_t i = 0; i < buffers.size(); ++i)
+    {
+        state.cached_bytes.fetch_sub(buffers[i].first, std::memory_order_relaxed);
+        give_shared_buffer(buffers[i].first, buffers[i].second);
+    }
+    thread_cache_destroyed = true;
+}
+
+/**
+ * @brief Get the cache of the calling thread.
+ * 
+ * @return The cache, null while the thread exits.
+ * @since 0.0.2
+ */
+static ThreadCache* get_thread_cache()
+{
+    if (thread_cache_destroyed)
+    {
+        return nullptr;
+    }
+    thread_local ThreadCache cache;
+    return &cache;
+}
+
+/**
+ * @brief Take a buffer from the cache of the thread, from the shared buckets, or from the system.
+ * 
+ * @param[in] size The size of the buffer in bytes.
+ * @return The buffer.
+ * @since 0.0.2
+ */
+static uchar* take_buffer(const size_t& size)
+{
+    PoolState& state = get_state();
+    if (size < MIN_POOLED_SIZE)
+    {
+        state.bypasses.fetch_add(1, std::memory_order_relaxed);
+        return allocate_aligned(size);
+    }
+    state.requests.fetch_add(1, std::memory_order_relaxed);
+    size_t bucket_size = get_bucket_size(size);
+
+    // The thread reuses its own buffers first, without a lock
+    ThreadCache* cache = get_thread_cache();
+    if (cache != nullptr)
+    {
+        for (size_t i = 0; i < cache->buffers.size(); ++i)
+        {
+            if (cache->buffers[i].first == bucket_size)
+            {
+                uchar* buffer = cache->buffers[i].second;
+                cache->buffers[i] = cache->buffers.back();
+                cache->buffers.pop_back();
+                state.cached_bytes.fetch_sub(bucket_size, std::memory_order_relaxed);
+                state.hits.fetch_add(1, std::memory_order_relaxed);
+                return buffer;
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        std::unordered_map<size_t, std::vector<uchar*>>::iterator it = state.buffers.find(bucket_size);
+        if (it != state.buffers.end() && !it->second.empty())
+        {
+            uchar* buffer = it->second.back();
+            it->second.pop_back();
+            state.cached_bytes.fetch_sub(bucket_size, std::memory_order_relaxed);
+            state.hits.fetch_add(1, std::memory_order_relaxed);
+            return buffer;
+        }
+    }
+    uchar* buffer = allocate_aligned(bucket_size);
+    add_allocated_bytes(bucket_size);
+    return buffer;
+}
+
+/**
+ * @brief Give a buffer back to the cache of the thread, or to the shared buckets when it is full.
+ * 
+ * @param[in] buffer The buffer.
+ * @param[in] size The size the buffer was taken with.
+ * @since 0.0.2
+ */
+static void give_buffer(uchar* buffer, const size_t& size)
+{
+    if (size < MIN_POOLED_SIZE)
+    {
+        free_aligned(buffer);
+        return;
+    }
+    size_t bucket_size = get_bucket_size(size);
+    ThreadCache* cache = get_thread_cache();
+    if (cache != nullptr && cache->buffers.size() < MAX_THREAD_CACHED_BUFFERS &&
+        get_state().cached_bytes.load(std::memory_order_relaxed) + bucket_size <= MAX_CACHED_BYTES)
+    {
+        get_state().cached_bytes.fetch_add(bucket_size, std::memory_order_relaxed);
+        cache->buffers.push_back(std::make_pair(bucket_size, buffer));
+        return;
+    }
+    give_shared_buffer(bucket_size, buffer);
+}
+
+#if CV_VERSION_MAJOR >= 3
+
+#if CV_VERSION_MAJOR >= 4
+typedef cv::AccessFlag AccessFlags;
+#else
+typedef int AccessFlags;
+#endif
+
+/**
+ * @brief A cv::Mat allocator that takes the buffers from the pool, like the standard allocator takes them from the
+ * heap.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class PooledMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           AccessFlags, cv::UMatUsageFlags) const override
+    {
+        size_t total = CV_ELEM_SIZE(type);
+        for (int i = dims - 1; i >= 0; --i)
+        {
+            if (step != nullptr)
+            {
+                if (data != nullptr && step[i] != CV_AUTOSTEP)
+                {
+                    CV_Assert(total <= step[i]);
+                    total = step[i];
+                }
+                else
+                {
+                    step[i] = total;
+                }
+            }
+            total *= sizes[i];
+        }
+        cv::UMatData* mat_data = new cv::UMatData(this);
+        mat_data->data = mat_data->origdata = data != nullptr ? (uchar*)data : take_buffer(total);
+        mat_data->size = total;
+        if (data != nullptr)
+        {
+            mat_data->flags |= cv::UMatData::USER_ALLOCATED;
+        }
+        return mat_data;
+    }
+
+    bool allocate(cv::UMatData* data, AccessFlags, cv::UMatUsageFlags) const override
+    {
+        return data != nullptr;
+    }
+
+    void deallocate(cv::UMatData* data) const override
+    {
+        if (data == nullptr)
+        {
+            return;
+        }
+        CV_Assert(data->urefcount == 0 && data->refcount == 0);
+        if (!(data->flags & cv::UMatData::USER_ALLOCATED))
+        {
+            give_buffer(data->origdata, data->size);
+            data->origdata = nullptr;
+        }
+        delete data;
+    }
+};
+
+#endif
+
+cv::MatAllocator* get_buffer_pool()
+{
+#if CV_VERSION_MAJOR >= 3
+    // Never destroyed, like the state, since the static cv::Mat may be released after it
+    static PooledMatAllocator* allocator = new PooledMatAllocator();
+    return allocator;
+#else
+    return nullptr;
+#endif
+}
+
+void install_buffer_pool()
+{
+    cv::MatAllocator* allocator = get_buffer_pool();
+    if (allocator != nullptr)
+    {
+        cv::Mat::setDefaultAllocator(allocator);
+    }
+}
+
+void release_buffer_pool()
+{
+    PoolState& state = get_state();
+    ThreadCache* cache = get_thread_cache();
+    if (cache != nullptr)
+    {
+        for (size_t i = 0; i < cache->buffers.size(); ++i)
+        {
+            state.cached_bytes.fetch_sub(cache->buffers[i].first, std::memory_order_relaxed);
+            state.allocated_bytes.fetch_sub(cache->buffers[i].first, std::memory_order_relaxed);
+            free_aligned(cache->buffers[i].second);
+        }
+        cache->buffers.clear();
+    }
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (std::unordered_map<size_t, std::vector<uchar*>>::iterator it = state.buffers.begin();
+         it != state.buffers.end(); ++it)
+    {
+        for (size_t i = 0; i < it->second.size(); ++i)
+        {
+            state.cached_bytes.fetch_sub(it->first, std::memory_order_relaxed);
+            state.allocated_bytes.fetch_sub(it->first, std::memory_order_relaxed);
+            free_aligned(it->second[i]);
+        }
+    }
+    state.buffers.clear();
+}
+
+BufferPoolStatistics get_buffer_pool_statistics()
+{
+    PoolState& state = get_state();
+    BufferPoolStatistics statistics;
+    statistics.requests = state.requests.load(std::memory_order_relaxed);
+    statistics.hits = state.hits.load(std::memory_order_relaxed);
+    statistics.bypasses = state.bypasses.load(std::memory_order_relaxed);
+    statistics.cached_bytes = state.cached_bytes.load(std::memory_order_relaxed);
+    statistics.peak_bytes = state.peak_bytes.load(std::memory_order_relaxed);
+    statistics.peak_rss = get_peak_rss();
+    return statistics;
+}
+
+void write_buffer_pool_statistics(std::ostream& stream)
+{
+    BufferPoolStatistics statistics = get_buffer_pool_statistics();
+    double hit_rate = statistics.requests > 0 ? 100.0 * statistics.hits / statistics.requests : 0;
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(1);
+    stream << "Buffer pool: " << statistics.hits << " of " << statistics.requests << " buffers reused (" << hit_rate
+           << "%), " << statistics.bypasses << " small buffers not pooled, " << statistics.cached_bytes / 1048576.0
+           << " MiB cached, " << statistics.peak_bytes / 1048576.0 << " MiB peak, "
+           << statistics.peak_rss / 1048576.0 << " MiB peak RSS\n";
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+size_t get_peak_rss()
+{
+#if defined(__unix__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return 0;
+    }
+#if defined(__APPLE__)
+    return (size_t)usage.ru_maxrss;
+#else
+    return (size_t)usage.ru_maxrss * 1024;
+#endif
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,83 @@
+/**
+ * @file canny_edge_detection.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The stages of the Canny edge detection.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef CANNY_EDGE_DETECTION_CANNY_EDGE_DETECTION_HPP
+#define CANNY_EDGE_DETECTION_CANNY_EDGE_DETECTION_HPP
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief Smooth an image with the 5x5 Gaussian filter, the 2-pixel border is copied from the input.
+ * 
+ * @param[in] image The 8-bit single-channel image.
+ * @return The smoothed image.
+ * @since 0.0.2
+ */
+cv::Mat gauss_filter(const cv::Mat& image);
+
+/**
+ * @brief Get the magnitude of the Sobel gradient, the 1-pixel border is 0.
+ * 
+ * @param[in] smoothed The 8-bit single-channel smoothed image.
+ * @param[out] magnitude The 8-bit single-channel gradient magnitude.
+ * @since 0.0.2
+ */
+void get_gradient_magnitude(const cv::Mat& smoothed, cv::Mat& magnitude);
+
+/**
+ * @brief Zero out the gradient magnitude of the pixels that are not maxima along the gradient direction.
+ * 
+ * @param[in] smoothed The 8-bit single-channel smoothed image the gradient directions are computed from.
+ * @param[in,out] magnitude The 8-bit single-channel gradient magnitude.
+ * @since 0.0.2
+ */
+void suppress_non_maxima(const cv::Mat& smoothed, cv::Mat& magnitude);
+
+/**
+ * @brief Keep the strong edges and the weak edges next to a strong edge.
+ * 
+ * @param[in,out] magnitude The 8-bit single-channel suppressed gradient magnitude, it becomes the edge image with
+ * the strong edges set to 255 and the weak edges kept.
+ * @param[in] high_threshold The magnitude above which an edge is strong.
+ * @param[in] low_threshold The magnitude below which a pixel is not an edge.
+ * @since 0.0.2
+ */
+void apply_hysteresis(cv::Mat& magnitude, const int& high_threshold, const int& low_threshold);
+
+/**
+ * @brief Detect the edges of an image with all the stages of the Canny edge detection.
+ * 
+ * @param[in] image The 8-bit single-channel image.
+ * @param[out] edges The 8-bit single-channel edge image.
+ * @param[in] high_threshold The magnitude above which an edge is strong.
+ * @param[in] low_threshold The magnitude below which a pixel is not an edge.
+ * @since 0.0.2
+ */
+void detect_edges(const cv::Mat& image, cv::Mat& edges, const int& high_threshold = 110, const int& low_threshold = 80);
+
+/**
+ * @brief Detect the edges of an image and return them as a list of pixels instead of an edge image.
+ * 
+ * The edges are the non-zero pixels of the edge image of detect_edges, in the row-major order.
+ * 
+ * @param[in] image The 8-bit single-channel image.
+ * @param[out] points The edge pixels, x is the column and y is the row.
+ * @param[out] orientations If not null, the angle of the gradient of every edge pixel in radians in the range
+ * [-pi, pi], with x to the right and y down. It is the normal angle of a line through the pixel.
+ * @param[in] high_threshold The magnitude above which an edge is strong.
+ * @param[in] low_threshold The magnitude below which a pixel is not an edge.
+ * @since 0.0.2
+ */
+void detect_edge_points(const cv::Mat& image, std::vector<cv::Point>& points, std::vector<float>* orientations = nullptr,
+                        const int& high_threshold = 110, const int& low_threshold = 80);
+
+#endif // CANNY_EDGE_DETECTION_CANNY_EDGE_DETECTION_HPP
@@ -1,19 +1,24 @@
-#include <cmath>
-#include <iostream>
+/**
+ * @file canny_edge_detection.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The stages of the Canny edge detection.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
 
-#include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
+#include "canny_edge_detection/canny_edge_detection.hpp"
 
-using namespace cv;
-using namespace std;
+#include <cmath>
 
-int const Th = 110;
-int const T1 = 80;
+#include "instrumentation/instrumentation.hpp"
 
-Mat gaussFilter(Mat image)
+cv::Mat gauss_filter(const cv::Mat& image)
 {
-    Mat gauImg = image.clone();
+    CVBASIC_SCOPED_TIMER("gauss_filter");
+    CVBASIC_COUNT(PIXELS_PROCESSED, image.total());
+    cv::Mat filtered = image.clone();
     for (int i = 2; i < image.rows - 2; i++)
     {
         for (int j = 2; j < image.cols - 2; j++)
@@ -24,103 +29,181 @@ Mat gaussFilter(Mat image)
             int gau3 = 4 * image.at<uchar>(i + 1, j - 2) + 9 * image.at<uchar>(i + 1, j - 1) + 12 * image.at<uchar>(i + 1, j) + 9 * image.at<uchar>(i + 1, j + 1) + 4 * image.at<uchar>(i + 1, j + 2);
             int gau4 = 2 * image.at<uchar>(i + 2, j - 2) + 4 * image.at<uchar>(i + 2, j - 1) + 5 * image.at<uchar>(i + 2, j) + 4 * image.at<uchar>(i + 2, j + 1) + 2 * image.at<uchar>(i + 2, j + 2);
             int gau = (gau0 + gau1 + gau2 + gau3 + gau4) / 159;
-            gauImg.at<uchar>(i, j) = gau;
+            filtered.at<uchar>(i, j) = gau;
         }
     }
-    return gauImg;
+    return filtered;
 }
 
-int main()
+void get_gradient_magnitude(const cv::Mat& smoothed, cv::Mat& magnitude)
 {
-    Mat orgImg = imread("hanoi.png", 0);
-    Mat gauImg = gaussFilter(orgImg);
-
-    Mat aftImg = Mat::zeros(gauImg.rows, gauImg.cols, CV_8UC1);
-    for (int i = 1; i < aftImg.rows - 1; i++)
+    CVBASIC_SCOPED_TIMER("get_gradient_magnitude");
+    CVBASIC_COUNT(PIXELS_PROCESSED, smoothed.total());
+    magnitude = cv::Mat::zeros(smoothed.rows, smoothed.cols, CV_8UC1);
+    for (int i = 1; i < magnitude.rows - 1; i++)
     {
-        for (int j = 1; j < aftImg.cols - 1; j++)
+        for (int j = 1; j < magnitude.cols - 1; j++)
         {
-            int Gx = gauImg.at<uchar>(i + 1, j - 1) + 2 * gauImg.at<uchar>(i + 1, j) + gauImg.at<uchar>(i + 1, j + 1) - gauImg.at<uchar>(i - 1, j - 1) - 2 * gauImg.at<uchar>(i - 1, j) - gauImg.at<uchar>(i - 1, j + 1);
-            int Gy = gauImg.at<uchar>(i - 1, j + 1) + 2 * gauImg.at<uchar>(i, j + 1) + gauImg.at<uchar>(i + 1, j + 1) - gauImg.at<uchar>(i - 1, j - 1) - 2 * gauImg.at<uchar>(i, j - 1) - gauImg.at<uchar>(i + 1, j - 1);
-            aftImg.at<uchar>(i, j) = (int)(sqrtf((float)(Gx * Gx) + (float)(Gy * Gy)));
+            int Gx = smoothed.at<uchar>(i + 1, j - 1) + 2 * smoothed.at<uchar>(i + 1, j) + smoothed.at<uchar>(i + 1, j + 1) - smoothed.at<uchar>(i - 1, j - 1) - 2 * smoothed.at<uchar>(i - 1, j) - smoothed.at<uchar>(i - 1, j + 1);
+            int Gy = smoothed.at<uchar>(i - 1, j + 1) + 2 * smoothed.at<uchar>(i, j + 1) + smoothed.at<uchar>(i + 1, j + 1) - smoothed.at<uchar>(i - 1, j - 1) - 2 * smoothed.at<uchar>(i, j - 1) - smoothed.at<uchar>(i + 1, j - 1);
+            magnitude.at<uchar>(i, j) = (int)(sqrtf((float)(Gx * Gx) + (float)(Gy * Gy)));
         }
     }
+}
 
-    for (int i = 1; i < aftImg.rows - 1; i++)
+void suppress_non_maxima(const cv::Mat& smoothed, cv::Mat& magnitude)
+{
+    CVBASIC_SCOPED_TIMER("suppress_non_maxima");
+    CVBASIC_COUNT(PIXELS_PROCESSED, magnitude.total());
+    for (int i = 1; i < magnitude.rows - 1; i++)
     {
-        for (int j = 1; j < aftImg.cols - 1; j++)
+        for (int j = 1; j < magnitude.cols - 1; j++)
         {
-            int Gx = gauImg.at<uchar>(i + 1, j - 1) + 2 * gauImg.at<uchar>(i + 1, j) + gauImg.at<uchar>(i + 1, j + 1) - gauImg.at<uchar>(i - 1, j - 1) - 2 * gauImg.at<uchar>(i - 1, j) - gauImg.at<uchar>(i - 1, j + 1);
-            int Gy = gauImg.at<uchar>(i - 1, j + 1) + 2 * gauImg.at<uchar>(i, j + 1) + gauImg.at<uchar>(i + 1, j + 1) - gauImg.at<uchar>(i - 1, j - 1) - 2 * gauImg.at<uchar>(i, j - 1) - gauImg.at<uchar>(i + 1, j - 1);
+            int Gx = smoothed.at<uchar>(i + 1, j - 1) + 2 * smoothed.at<uchar>(i + 1, j) + smoothed.at<uchar>(i + 1, j + 1) - smoothed.at<uchar>(i - 1, j - 1) - 2 * smoothed.at<uchar>(i - 1, j) - smoothed.at<uchar>(i - 1, j + 1);
+            int Gy = smoothed.at<uchar>(i - 1, j + 1) + 2 * smoothed.at<uchar>(i, j + 1) + smoothed.at<uchar>(i + 1, j + 1) - smoothed.at<uchar>(i - 1, j - 1) - 2 * smoothed.at<uchar>(i, j - 1) - smoothed.at<uchar>(i + 1, j - 1);
             if (Gx == 0)
             {
-                if (aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i, j - 1) || aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i, j + 1))
+                if (magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i, j - 1) || magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i, j + 1))
                 {
-                    aftImg.at<uchar>(i, j) = 0;
+                    magnitude.at<uchar>(i, j) = 0;
                 }
             }
             else
             {
                 if (atanf((float)Gy / (float)Gx) >= 3 * M_PI / 8 || atanf((float)Gy / (float)Gx) <= -3 * M_PI / 8)
                 {
-                    if (aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i, j - 1) || aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i, j + 1))
+                    if (magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i, j - 1) || magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i, j + 1))
                     {
-                        aftImg.at<uchar>(i, j) = 0;
+                        magnitude.at<uchar>(i, j) = 0;
                     }
                 }
 
                 else if (atanf((float)Gy / (float)Gx) >= -M_PI / 8 || atanf((float)Gy / (float)Gx) <= M_PI / 8)
                 {
-                    if (aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i - 1, j) || aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i - 1, j))
+                    if (magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i - 1, j) || magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i - 1, j))
                     {
-                        aftImg.at<uchar>(i, j) = 0;
+                        magnitude.at<uchar>(i, j) = 0;
                     }
                 }
 
                 else if (atanf((float)Gy / (float)Gx) > -3 * M_PI / 8 && atanf((float)Gy / (float)Gx) < -M_PI / 8)
                 {
-                    if (aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i - 1, j + 1) || aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i - 1, j - 1))
+                    if (magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i - 1, j + 1) || magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i - 1, j - 1))
                     {
-                        aftImg.at<uchar>(i, j) = 0;
+                        magnitude.at<uchar>(i, j) = 0;
                     }
                 }
 
                 else if (atanf((float)Gy / (float)Gx) > M_PI / 8 || atanf((float)Gy / (float)Gx) < 3 * M_PI / 8)
                 {
-                    if (aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i - 1, j - 1) || aftImg.at<uchar>(i, j) < aftImg.at<uchar>(i - 1, j + 1))
+                    if (magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i - 1, j - 1) || magnitude.at<uchar>(i, j) < magnitude.at<uchar>(i - 1, j + 1))
                     {
-                        aftImg.at<uchar>(i, j) = 0;
+                        magnitude.at<uchar>(i, j) = 0;
                     }
                 }
             }
         }
     }
+}
 
-    for (int i = 1; i < aftImg.rows - 1; i++)
+/**
+ * @brief Apply the hysteresis thresholding and report every pixel that stays an edge.
+ * 
+ * Every pixel is only written when it is visited, so its value is final and the edges can be reported in the same
+ * pass.
+ * 
+ * @param[in,out] magnitude The 8-bit single-channel suppressed gradient magnitude.
+ * @param[in] high_threshold The magnitude above which an edge is strong.
+ * @param[in] low_threshold The magnitude below which a pixel is not an edge.
+ * @param[in] emit The function called with the row and the column of every edge.
+ * @since 0.0.2
+ */
+template <typename Emit>
+static inline void threshold_edges(cv::Mat& magnitude, const int& high_threshold, const int& low_threshold, Emit emit)
+{
+    for (int i = 1; i < magnitude.rows - 1; i++)
     {
-        for (int j = 1; j < aftImg.cols - 1; j++)
+        for (int j = 1; j < magnitude.cols - 1; j++)
         {
-            if (aftImg.at<uchar>(i, j) > Th)
+            if (magnitude.at<uchar>(i, j) > high_threshold)
             {
-                aftImg.at<uchar>(i, j) = 255;
+                magnitude.at<uchar>(i, j) = 255;
+                emit(i, j);
             }
-            else if ((aftImg.at<uchar>(i, j) < T1))
+            else if ((magnitude.at<uchar>(i, j) < low_threshold))
             {
-                aftImg.at<uchar>(i, j) = 0;
+                magnitude.at<uchar>(i, j) = 0;
             }
             else
             {
-                if (aftImg.at<uchar>(i - 1, j - 1) < Th && aftImg.at<uchar>(i - 1, j) < Th && aftImg.at<uchar>(i - 1, j + 1) < Th && aftImg.at<uchar>(i, j - 1) < Th && aftImg.at<uchar>(i, j + 1) < Th && aftImg.at<uchar>(i + 1, j - 1) < Th && aftImg.at<uchar>(i + 1, j) < Th && aftImg.at<uchar>(i + 1, j + 1) < Th)
+                if (magnitude.at<uchar>(i - 1, j - 1) < high_threshold && magnitude.at<uchar>(i - 1, j) < high_threshold && magnitude.at<uchar>(i - 1, j + 1) < high_threshold && magnitude.at<uchar>(i, j - 1) < high_threshold && magnitude.at<uchar>(i, j + 1) < high_threshold && magnitude.at<uchar>(i + 1, j - 1) < high_threshold && magnitude.at<uchar>(i + 1, j) < high_threshold && magnitude.at<uchar>(i + 1, j + 1) < high_threshold)
                 {
-                    aftImg.at<uchar>(i, j) = 0;
+                    magnitude.at<uchar>(i, j) = 0;
+                }
+                else
+                {
+                    emit(i, j);
                 }
             }
         }
     }
+}
+
+/**
+ * @brief Get the direction of the Sobel gradient of a pixel.
+ * 
+ * @param[in] smoothed The 8-bit single-channel smoothed image.
+ * @param[in] i The row of the pixel, not on the border.
+ * @param[in] j The column of the pixel, not on the border.
+ * @return The angle of the gradient in radians in the range [-pi, pi], with x to the right and y down.
+ * @since 0.0.2
+ */
+static inline float get_gradient_orientation(const cv::Mat& smoothed, const int& i, const int& j)
+{
+    // Gx is the derivative along the rows and Gy along the columns, like in the other stages
+    int Gx = smoothed.at<uchar>(i + 1, j - 1) + 2 * smoothed.at<uchar>(i + 1, j) + smoothed.at<uchar>(i + 1, j + 1) - smoothed.at<uchar>(i - 1, j - 1) - 2 * smoothed.at<uchar>(i - 1, j) - smoothed.at<uchar>(i - 1, j + 1);
+    int Gy = smoothed.at<uchar>(i - 1, j + 1) + 2 * smoothed.at<uchar>(i, j + 1) + smoothed.at<uchar>(i + 1, j + 1) - smoothed.at<uchar>(i - 1, j - 1) - 2 * smoothed.at<uchar>(i, j - 1) - smoothed.at<uchar>(i + 1, j - 1);
+    return atan2f((float)Gx, (float)Gy);
+}
 
-    imshow("Original Image", orgImg);
-    imshow("Gauss Image", gauImg);
-    imshow("After Image", aftImg);
-    waitKey(0);
-    return 0;
+void apply_hysteresis(cv::Mat& magnitude, const int& high_threshold, const int& low_threshold)
+{
+    CVBASIC_SCOPED_TIMER("apply_hysteresis");
+    CVBASIC_COUNT(PIXELS_PROCESSED, magnitude.total());
+    threshold_edges(magnitude, high_threshold, low_threshold, [](const int&, const int&) {});
+}
+
+void detect_edges(const cv::Mat& image, cv::Mat& edges, const int& high_threshold, const int& low_threshold)
+{
+    CVBASIC_SCOPED_TIMER("detect_edges");
+    cv::Mat smoothed = gauss_filter(image);
+    get_gradient_magnitude(smoothed, edges);
+    suppress_non_maxima(smoothed, edges);
+    apply_hysteresis(edges, high_threshold, low_threshold);
+}
+
+void detect_edge_points(const cv::Mat& image, std::vector<cv::Point>& points, std::vector<float>* orientations,
+                        const int& high_threshold, const int& low_threshold)
+{
+    CVBASIC_SCOPED_TIMER("detect_edge_points");
+    cv::Mat smoothed = gauss_filter(image);
+    cv::Mat magnitude;
+    get_gradient_magnitude(smoothed, magnitude);
+    suppress_non_maxima(smoothed, magnitude);
+
+    // Collect the edges while they are thresholded instead of scanning an edge image afterwards
+    CVBASIC_SCOPED_TIMER("threshold_edge_points");
+    CVBASIC_COUNT(PIXELS_PROCESSED, magnitude.total());
+    points.clear();
+    if (orientations != nullptr)
+    {
+        orientations->clear();
+    }
+    threshold_edges(magnitude, high_threshold, low_threshold, [&](const int& i, const int& j) {
+        points.push_back(cv::Point(j, i));
+        if (orientations != nullptr)
+        {
+            orientations->push_back(get_gradient_orientation(smoothed, i, j));
+        }
+    });
 }
@@ -0,0 +1,37 @@
+#include <iostream>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "buffer_pool/buffer_pool.hpp"
+#include "canny_edge_detection/canny_edge_detection.hpp"
+#include "instrumentation/instrumentation.hpp"
+
+using namespace cv;
+using namespace std;
+
+int const Th = 110;
+int const T1 = 80;
+
+int main()
+{
+    start_instrumentation();
+    install_buffer_pool();
+
+    Mat orgImg = imread("hanoi.png", 0);
+    Mat gauImg = gauss_filter(orgImg);
+
+    Mat aftImg;
+    get_gradient_magnitude(gauImg, aftImg);
+    suppress_non_maxima(gauImg, aftImg);
+    apply_hysteresis(aftImg, Th, T1);
+
+    imshow("Original Image", orgImg);
+    imshow("Gauss Image", gauImg);
+    imshow("After Image", aftImg);
+    waitKey(0);
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("canny_edge_detection");
+    return 0;
+}
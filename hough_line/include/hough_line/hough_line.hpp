@@ -0,0 +1,141 @@
+/**
+ * @file hough_line.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The Hough line transform for line detection.
+ * @since 0.0.1
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef HOUGH_LINE_HOUGH_LINE_HPP
+#define HOUGH_LINE_HOUGH_LINE_HPP
+
+#include <cmath>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief A struct to store the data of a line in the Polar coordinate system.
+ * 
+ * @since 0.0.1
+ * 
+ */
+struct Line
+{
+    float rho;
+    float theta;
+};
+
+/**
+ * @brief A class to detect lines in an image using the Hough transform.
+ * 
+ * @since 0.0.1
+ * 
+ */
+class HoughLine
+{
+private:
+    float delta_theta_;         //!< The angle resolution of the accumulator in radians.
+    int accumulator_threshold_; //!< The accumulator threshold parameter, only those lines get enough votes will be returned.
+    int rho_range_;             //!< The rho range around the maximum cell that belongs to the same line.
+    float theta_range_;         //!< The theta range around the maximum cell that belongs to the same line.
+    float orientation_range_;   //!< The theta range around the gradient orientation of an edge pixel that it votes for.
+
+    /**
+     * @brief Select the lines from the peaks of the accumulator.
+     * 
+     * @param[in,out] accumulator The theta-major accumulator, the cells around every peak are zeroed out.
+     * @return The vector of lines detected.
+     * @since 0.0.2
+     */
+    std::vector<Line> select_peaks(cv::Mat& accumulator) const;
+
+public:
+    /**
+     * @brief Construct a new HoughLine object.
+     * 
+     * @param[in] delta_theta The angle resolution of the accumulator in radians.
+     * @param[in] accumulator_threshold The accumulator threshold parameter, only those lines get enough votes will be returned.
+     * @param[in] rho_range The rho range around the maximum cell that belongs to the same line.
+     * @param[in] theta_range The theta range around the maximum cell that belongs to the same line.
+     * @param[in] orientation_range The theta range around the gradient orientation of an edge pixel that it votes for.
+     * @since 0.0.1
+     */
+    HoughLine(const float& delta_theta = M_PI / 180,
+              const int& accumulator_threshold = 100,
+              const int& rho_range = 10,
+              const float& theta_range = M_PI / 18,
+              const float& orientation_range = M_PI / 36);
+
+    /**
+     * @brief Destroy the HoughLine object.
+     * 
+     * @since 0.0.1
+     * 
+     */
+    ~HoughLine();
+
+    /**
+     * @brief Detect lines in the given image.
+     * 
+     * @param[in] image The input image.
+     * @return The vector of lines detected.
+     * @since 0.0.1
+     */
+    std::vector<Line> detect_lines(const cv::Mat& image) const;
+
+    /**
+     * @brief Detect lines from a list of edge pixels, every pixel votes for every theta.
+     * 
+     * @param[in] points The edge pixels, x is the column and y is the row.
+     * @param[in] size The size of the image the edge pixels belong to.
+     * @return The vector of lines detected.
+     * @since 0.0.2
+     */
+    std::vector<Line> detect_lines(const std::vector<cv::Point>& points, const cv::Size& size) const;
+
+    /**
+     * @brief Detect lines from a list of edge pixels and their gradient orientations.
+     * 
+     * The gradient of an edge pixel is normal to the line through it, so every pixel only votes for the theta within
+     * the orientation range around its orientation and around the opposite one.
+     * 
+     * @param[in] points The edge pixels, x is the column and y is the row.
+     * @param[in] orientations The gradient angle of every edge pixel in radians, with x to the right and y down.
+     * @param[in] size The size of the image the edge pixels belong to.
+     * @return The vector of lines detected.
+     * @since 0.0.2
+     */
+    std::vector<Line> detect_lines(const std::vector<cv::Point>& points, const std::vector<float>& orientations,
+                                   const cv::Size& size) const;
+
+    /**
+     * @brief Vote for the lines through a list of edge pixels, every pixel votes for every theta.
+     * 
+     * The accumulator is theta-major, row i holds the votes for the theta i * delta_theta and column j the votes for
+     * the rho j. Its cells are the narrowest counts that cannot overflow for the number of edge pixels and the size of
+     * the image.
+     * 
+     * @param[in] points The edge pixels, x is the column and y is the row, every pixel listed once.
+     * @param[in] size The size of the image the edge pixels belong to.
+     * @return The accumulator, CV_8UC1, CV_16UC1 or CV_32SC1.
+     * @since 0.0.2
+     */
+    cv::Mat accumulate(const std::vector<cv::Point>& points, const cv::Size& size) const;
+
+    /**
+     * @brief Vote for the lines through a list of edge pixels around their gradient orientations.
+     * 
+     * @param[in] points The edge pixels, x is the column and y is the row.
+     * @param[in] orientations The gradient angle of every edge pixel in radians, with x to the right and y down.
+     * @param[in] size The size of the image the edge pixels belong to.
+     * @return The accumulator, laid out like the one of the other overload.
+     * @since 0.0.2
+     */
+    cv::Mat accumulate(const std::vector<cv::Point>& points, const std::vector<float>& orientations,
+                       const cv::Size& size) const;
+};
+
+#endif // HOUGH_LINE_HOUGH_LINE_HPP
@@ -8,80 +8,276 @@
  * 
  */
 
-#include <cmath>
-#include <iostream>
+#include "hough_line/hough_line.hpp"
 
-#include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
-#include <opencv2/imgproc/imgproc.hpp>
+#include <algorithm>
+#include <climits>
+
+#include "instrumentation/instrumentation.hpp"
+
+static const size_t POINT_BLOCK_SIZE = 1024;            //!< The edge pixels voting together, 8 KiB of coordinates in L1.
+static const size_t ACCUMULATOR_TILE_BYTES = 256 << 10; //!< The accumulator rows kept in L2 while the blocks vote.
 
 /**
- * @brief A struct to store the data of a line in the Polar coordinate system.
+ * @brief Choose the narrowest accumulator type that cannot overflow.
  * 
- * @since 0.0.1
+ * A cell counts the edge pixels in a strip one rho bin wide, there are at most two of them in every row or in every
+ * column of the image, and at most one per edge pixel.
  * 
+ * @param[in] number_of_points The number of edge pixels.
+ * @param[in] size The size of the image the edge pixels belong to.
+ * @return CV_8UC1, CV_16UC1 or CV_32SC1.
+ * @since 0.0.2
  */
-struct Line
+static int get_accumulator_type(const size_t& number_of_points, const cv::Size& size)
 {
-    float rho;
-    float theta;
-};
+    size_t max_votes = std::min(number_of_points, (size_t)2 * (std::max(size.width, size.height) + 1));
+    if (max_votes <= UCHAR_MAX)
+    {
+        return CV_8UC1;
+    }
+    if (max_votes <= USHRT_MAX)
+    {
+        return CV_16UC1;
+    }
+    return CV_32SC1;
+}
 
 /**
- * @brief A class to detect lines in an image using the Hough transform.
+ * @brief Let every edge pixel vote for every theta.
  * 
- * @since 0.0.1
+ * The rows of the accumulator are voted for in tiles that stay in the L2 cache, and every tile is voted for by
+ * blocks of edge pixels that stay in the L1 cache. The edge pixels of a block are close in the image, so their
+ * votes in a row land in close rho cells.
  * 
+ * @param[in] points The edge pixels, x is the column and y is the row.
+ * @param[in] cosines The cosine of every theta.
+ * @param[in] sines The sine of every theta.
+ * @param[in,out] accumulator The theta-major accumulator.
+ * @since 0.0.2
  */
-class HoughLine
+template <typename Count>
+static void vote_for_every_theta(const std::vector<cv::Point>& points, const std::vector<float>& cosines,
+                                 const std::vector<float>& sines, cv::Mat& accumulator)
 {
-private:
-    float delta_theta_;         //!< The angle resolution of the accumulator in radians.
-    int accumulator_threshold_; //!< The accumulator threshold parameter, only those lines get enough votes will be returned.
-    int rho_range_;             //!< The rho range around the maximum cell that belongs to the same line.
-    float theta_range_;         //!< The theta range around the maximum cell that belongs to the same line.
-
-public:
-    /**
-     * @brief Construct a new HoughLine object.
-     * 
-     * @param[in] delta_theta The angle resolution of the accumulator in radians.
-     * @param[in] accumulator_threshold The accumulator threshold parameter, only those lines get enough votes will be returned.
-     * @param[in] rho_range The rho range around the maximum cell that belongs to the same line.
-     * @param[in] theta_range The theta range around the maximum cell that belongs to the same line.
-     * @since 0.0.1
-     */
-    HoughLine(const float& delta_theta = M_PI / 180,
-              const int& accumulator_threshold = 100,
-              const int& rho_range = 10,
-              const float& theta_range = M_PI / 18);
-
-    /**
-     * @brief Destroy the HoughLine object.
-     * 
-     * @since 0.0.1
-     * 
-     */
-    ~HoughLine();
-
-    /**
-     * @brief Detect lines in the given image.
-     * 
-     * @param[in] image The input image.
-     * @return The vector of lines detected.
-     * @since 0.0.1
-     */
-    std::vector<Line> detect_lines(const cv::Mat& image) const;
-};
+    // Convert the coordinates once instead of once per vote, the buffers keep their capacity between the frames
+    static thread_local std::vector<float> xs, ys;
+    xs.resize(points.size());
+    ys.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        xs[i] = points[i].x;
+        ys[i] = points[i].y;
+    }
+
+    int tile_rows = std::max((int)(ACCUMULATOR_TILE_BYTES / accumulator.step[0]), 1);
+    for (int tile_begin = 0; tile_begin < accumulator.rows; tile_begin += tile_rows)
+    {
+        int tile_end = std::min(tile_begin + tile_rows, accumulator.rows);
+        for (size_t block_begin = 0; block_begin < points.size(); block_begin += POINT_BLOCK_SIZE)
+        {
+            size_t block_end = std::min(block_begin + POINT_BLOCK_SIZE, points.size());
+            for (int theta_index = tile_begin; theta_index < tile_end; ++theta_index)
+            {
+                Count* row = accumulator.ptr<Count>(theta_index);
+                float cosine = cosines[theta_index];
+                float sine = sines[theta_index];
+                for (size_t i = block_begin; i < block_end; ++i)
+                {
+                    int rho = cvRound(xs[i] * cosine + ys[i] * sine);
+                    if (rho >= 0)
+                    {
+                        ++row[rho];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Let every edge pixel vote for the theta around its gradient orientation and around the opposite one.
+ * 
+ * The edge pixels are sorted by the theta bin of their orientation, so every row of the accumulator is voted for by
+ * the few runs of edge pixels whose windows cover it, in one pass over the accumulator.
+ * 
+ * @param[in] points The edge pixels, x is the column and y is the row.
+ * @param[in] orientations The gradient angles of the edge pixels.
+ * @param[in] delta_theta The angle resolution of the accumulator in radians.
+ * @param[in] window The number of theta bins on each side of the orientation that an edge pixel votes for.
+ * @param[in] cosines The cosine of every theta.
+ * @param[in] sines The sine of every theta.
+ * @param[in,out] accumulator The theta-major accumulator.
+ * @since 0.0.2
+ */
+template <typename Count>
+static void vote_around_orientations(const std::vector<cv::Point>& points, const std::vector<float>& orientations,
+                                     const float& delta_theta, const int& window, const std::vector<float>& cosines,
+                                     const std::vector<float>& sines, cv::Mat& accumulator)
+{
+    // Counting sort by theta bin, the buffers keep their capacity between the frames of a thread
+    static thread_local std::vector<int> bins, bin_begins, bin_ends;
+    static thread_local std::vector<cv::Point> sorted_points;
+    int theta_index_max = accumulator.rows;
+    bins.resize(points.size());
+    bin_begins.assign(theta_index_max + 1, 0);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        bins[i] = (cvRound(orientations[i] / delta_theta) % theta_index_max + theta_index_max) % theta_index_max;
+        ++bin_begins[bins[i] + 1];
+    }
+    for (int bin = 0; bin < theta_index_max; ++bin)
+    {
+        bin_begins[bin + 1] += bin_begins[bin];
+    }
+    bin_ends.assign(bin_begins.begin(), bin_begins.end() - 1);
+    sorted_points.resize(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        sorted_points[bin_ends[bins[i]]++] = points[i];
+    }
+
+    // A pixel of bin b votes for b + side * theta_index_max / 2 + offset, so a row is voted for by the reverse bins
+    for (int theta_index = 0; theta_index < theta_index_max; ++theta_index)
+    {
+        Count* row = accumulator.ptr<Count>(theta_index);
+        float cosine = cosines[theta_index];
+        float sine = sines[theta_index];
+        for (int side = 0; side < 2; ++side)
+        {
+            int side_center = theta_index - side * theta_index_max / 2;
+            for (int offset = -window; offset <= window; ++offset)
+            {
+                int bin = ((side_center - offset) % theta_index_max + theta_index_max) % theta_index_max;
+                for (int i = bin_begins[bin]; i < bin_ends[bin]; ++i)
+                {
+                    int rho = cvRound(sorted_points[i].x * cosine + sorted_points[i].y * sine);
+                    if (rho >= 0)
+                    {
+                        ++row[rho];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Cast the votes of the edge pixels in an accumulator of the given cell type.
+ * 
+ * @param[in] points The edge pixels, x is the column and y is the row.
+ * @param[in] orientations The gradient angles of the edge pixels, null to vote for every theta.
+ * @param[in] delta_theta The angle resolution of the accumulator in radians.
+ * @param[in] window The number of theta bins on each side of the orientation that an edge pixel votes for.
+ * @param[in] cosines The cosine of every theta.
+ * @param[in] sines The sine of every theta.
+ * @param[in,out] accumulator The theta-major accumulator.
+ * @since 0.0.2
+ */
+template <typename Count>
+static void cast_votes(const std::vector<cv::Point>& points, const std::vector<float>* orientations,
+                       const float& delta_theta, const int& window, const std::vector<float>& cosines,
+                       const std::vector<float>& sines, cv::Mat& accumulator)
+{
+    if (orientations != nullptr)
+    {
+        vote_around_orientations<Count>(points, *orientations, delta_theta, window, cosines, sines, accumulator);
+    }
+    else
+    {
+        vote_for_every_theta<Count>(points, cosines, sines, accumulator);
+    }
+}
+
+/**
+ * @brief Vote for the lines through the edge pixels.
+ * 
+ * @param[in] points The edge pixels, x is the column and y is the row.
+ * @param[in] orientations The gradient angles of the edge pixels, null to vote for every theta.
+ * @param[in] size The size of the image the edge pixels belong to.
+ * @param[in] delta_theta The angle resolution of the accumulator in radians.
+ * @param[in] window The number of theta bins on each side of the orientation that an edge pixel votes for.
+ * @return The theta-major accumulator, its type is chosen by get_accumulator_type.
+ * @since 0.0.2
+ */
+static cv::Mat vote(const std::vector<cv::Point>& points, const std::vector<float>* orientations,
+                    const cv::Size& size, const float& delta_theta, const int& window)
+{
+    CVBASIC_SCOPED_TIMER("vote");
+    int rho_index_max = std::round(sqrtf((float)size.height * size.height + (float)size.width * size.width));
+    int theta_index_max = std::round(2 * M_PI / delta_theta);
+    cv::Mat accumulator = cv::Mat::zeros(cv::Size(rho_index_max, theta_index_max),
+                                         get_accumulator_type(points.size(), size));
+
+    // Compute the sines and cosines once per theta instead of once per vote
+    std::vector<float> cosines(theta_index_max), sines(theta_index_max);
+    for (int theta_index = 0; theta_index < theta_index_max; ++theta_index)
+    {
+        cosines[theta_index] = cos(theta_index * delta_theta);
+        sines[theta_index] = sin(theta_index * delta_theta);
+    }
+
+    // The windows around an orientation and around the opposite one must not overlap
+    if (orientations != nullptr && 2 * (2 * window + 1) > theta_index_max)
+    {
+        orientations = nullptr;
+    }
+    CVBASIC_COUNT(VOTES_CAST, (uint64_t)points.size() * (orientations ? 2 * (2 * window + 1) : theta_index_max));
+    switch (accumulator.depth())
+    {
+    case CV_8U:
+        cast_votes<uchar>(points, orientations, delta_theta, window, cosines, sines, accumulator);
+        break;
+    case CV_16U:
+        cast_votes<ushort>(points, orientations, delta_theta, window, cosines, sines, accumulator);
+        break;
+    default:
+        cast_votes<int>(points, orientations, delta_theta, window, cosines, sines, accumulator);
+        break;
+    }
+    return accumulator;
+}
+
+/**
+ * @brief Find the maximum cell of the accumulator.
+ * 
+ * The ties go to the smallest rho, then to the smallest theta, like the first maximum of a rho-major accumulator.
+ * 
+ * @param[in] accumulator The theta-major accumulator.
+ * @param[out] location The maximum cell, x is the rho index and y is the theta index.
+ * @return The votes of the maximum cell.
+ * @since 0.0.2
+ */
+template <typename Count>
+static int find_peak(const cv::Mat& accumulator, cv::Point& location)
+{
+    Count max_votes = accumulator.ptr<Count>(0)[0];
+    location = cv::Point(0, 0);
+    for (int theta_index = 0; theta_index < accumulator.rows; ++theta_index)
+    {
+        const Count* row = accumulator.ptr<Count>(theta_index);
+        for (int rho = 0; rho < accumulator.cols; ++rho)
+        {
+            if (row[rho] > max_votes || (row[rho] == max_votes && rho < location.x))
+            {
+                max_votes = row[rho];
+                location = cv::Point(rho, theta_index);
+            }
+        }
+    }
+    return max_votes;
+}
 
 HoughLine::HoughLine(const float& delta_theta,
                      const int& accumulator_threshold,
                      const int& rho_range,
-                     const float& theta_range)
+                     const float& theta_range,
+                     const float& orientation_range)
     : delta_theta_(delta_theta),
       accumulator_threshold_(accumulator_threshold),
       rho_range_(rho_range),
-      theta_range_(theta_range)
+      theta_range_(theta_range),
+      orientation_range_(orientation_range)
 {
 }
 
@@ -91,91 +287,89 @@ HoughLine::~HoughLine()
 
 std::vector<Line> HoughLine::detect_lines(const cv::Mat& image) const
 {
-    int rho_index_max = std::round(sqrtf((float)(image.rows * image.rows + image.cols * image.cols)));
-    int theta_index_max = std::round(2 * M_PI / delta_theta_);
-    cv::Mat accumulator = cv::Mat::zeros(cv::Size(theta_index_max, rho_index_max), CV_16UC1);
-    ushort* accumulator_data = (ushort*)accumulator.data;
+    CVBASIC_SCOPED_TIMER("detect_lines");
+    CVBASIC_COUNT(PIXELS_PROCESSED, image.total());
 
-    // Run the accumulator
+    // The edge pixels are black, the list keeps its capacity between the frames of a thread
+    static thread_local std::vector<cv::Point> points;
+    points.clear();
     for (int row_index = 0; row_index < image.rows; ++row_index)
     {
         for (int column_index = 0; column_index < image.cols; ++column_index)
         {
-            // The edge pixels are black
             if (image.data[row_index * image.cols + column_index] == 0)
             {
-                for (float theta = 0; theta < 2 * M_PI; theta += delta_theta_)
-                {
-                    int rho = std::round(column_index * cos(theta) + row_index * sin(theta));
-                    if (rho >= 0)
-                    {
-                        int theta_index = std::round(theta / delta_theta_);
-                        ++accumulator_data[rho * accumulator.cols + theta_index];
-                    }
-                }
+                points.push_back(cv::Point(column_index, row_index));
             }
         }
     }
+    return detect_lines(points, image.size());
+}
+
+std::vector<Line> HoughLine::detect_lines(const std::vector<cv::Point>& points, const cv::Size& size) const
+{
+    cv::Mat accumulator = accumulate(points, size);
+    return select_peaks(accumulator);
+}
+
+std::vector<Line> HoughLine::detect_lines(const std::vector<cv::Point>& points, const std::vector<float>& orientations,
+                                          const cv::Size& size) const
+{
+    cv::Mat accumulator = accumulate(points, orientations, size);
+    return select_peaks(accumulator);
+}
+
+cv::Mat HoughLine::accumulate(const std::vector<cv::Point>& points, const cv::Size& size) const
+{
+    return vote(points, nullptr, size, delta_theta_, 0);
+}
+
+cv::Mat HoughLine::accumulate(const std::vector<cv::Point>& points, const std::vector<float>& orientations,
+                              const cv::Size& size) const
+{
+    CV_Assert(orientations.size() == points.size());
+    return vote(points, &orientations, size, delta_theta_, cvRound(orientation_range_ / delta_theta_));
+}
+
+std::vector<Line> HoughLine::select_peaks(cv::Mat& accumulator) const
+{
+    CVBASIC_SCOPED_TIMER("select_peaks");
 
     // Run the peak selection algorithm
-    int row_range = rho_range_;
-    int column_range = std::round(theta_range_ / delta_theta_);
+    int rho_index_range = rho_range_;
+    int theta_index_range = std::round(theta_range_ / delta_theta_);
     std::vector<Line> lines;
     while (true)
     {
         // Find the maximum cell in the accumulator
-        double max_cell_value;
         cv::Point max_cell_location;
-        cv::minMaxLoc(accumulator, nullptr, &max_cell_value, nullptr, &max_cell_location);
-        if ((int)max_cell_value < accumulator_threshold_)
+        int max_cell_value;
+        switch (accumulator.depth())
         {
+        case CV_8U:
+            max_cell_value = find_peak<uchar>(accumulator, max_cell_location);
+            break;
+        case CV_16U:
+            max_cell_value = find_peak<ushort>(accumulator, max_cell_location);
+            break;
+        default:
+            max_cell_value = find_peak<int>(accumulator, max_cell_location);
             break;
         }
-
-        // Zero out the area around the maximum cell that belongs to the same line
-        for (int row_index = std::max(max_cell_location.y - row_range, 0); row_index < std::min(max_cell_location.y + row_range, accumulator.rows); ++row_index)
+        if (max_cell_value < accumulator_threshold_)
         {
-            for (int column_index = std::max(max_cell_location.x - column_range, 0); column_index < std::min(max_cell_location.x + column_range, accumulator.cols); ++column_index)
-            {
-                accumulator_data[row_index * accumulator.cols + column_index] = 0;
-            }
+            break;
         }
-        float rho = max_cell_location.y;
-        float theta = max_cell_location.x * delta_theta_;
+
+        // Zero out the area around the maximum cell that belongs to the same line
+        int rho_begin = std::max(max_cell_location.x - rho_index_range, 0);
+        int rho_end = std::min(max_cell_location.x + rho_index_range, accumulator.cols);
+        int theta_begin = std::max(max_cell_location.y - theta_index_range, 0);
+        int theta_end = std::min(max_cell_location.y + theta_index_range, accumulator.rows);
+        accumulator(cv::Rect(rho_begin, theta_begin, rho_end - rho_begin, theta_end - theta_begin)).setTo(0);
+        float rho = max_cell_location.x;
+        float theta = max_cell_location.y * delta_theta_;
         lines.push_back(Line{rho, theta});
     }
     return lines;
 }
-
-/**
- * @brief The main function.
- * 
- * @param[in] argc The argument count.
- * @param[in] argv The argument vector.
- * @return The status value.
- * @since 0.0.1
- */
-int main(int argc, char** argv)
-{
-    if (argc != 2)
-    {
-        printf("To run the Hough line detection, type ./hough_line <image_file>\n");
-        return 1;
-    }
-    cv::Mat image = cv::imread(argv[1], 0);
-    if (image.empty())
-    {
-        printf("The input image is empty.\n");
-        return 1;
-    }
-    cv::threshold(image, image, 200, 255, cv::THRESH_BINARY);
-
-    // Apply the Hough line detection
-    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18);
-    std::vector<Line> lines = hough_line.detect_lines(image);
-    for (size_t i = 0; i < lines.size(); ++i)
-    {
-        std::cout << "(rho, theta) = (" << lines[i].rho << ", " << lines[i].theta << ")\n";
-    }
-    return 0;
-}
@@ -0,0 +1,57 @@
+/**
+ * @file hough_line_main.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The Hough line detection on an edge image.
+ * @since 0.0.1
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <iostream>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "buffer_pool/buffer_pool.hpp"
+#include "hough_line/hough_line.hpp"
+#include "instrumentation/instrumentation.hpp"
+
+/**
+ * @brief The main function.
+ * 
+ * @param[in] argc The argument count.
+ * @param[in] argv The argument vector.
+ * @return The status value.
+ * @since 0.0.1
+ */
+int main(int argc, char** argv)
+{
+    start_instrumentation();
+    install_buffer_pool();
+
+    if (argc != 2)
+    {
+        printf("To run the Hough line detection, type ./hough_line <image_file>\n");
+        return 1;
+    }
+    cv::Mat image = cv::imread(argv[1], 0);
+    if (image.empty())
+    {
+        printf("The input image is empty.\n");
+        return 1;
+    }
+    cv::threshold(image, image, 200, 255, cv::THRESH_BINARY);
+
+    // Apply the Hough line detection
+    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18);
+    std::vector<Line> lines = hough_line.detect_lines(image);
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        std::cout << "(rho, theta) = (" << lines[i].rho << ", " << lines[i].theta << ")\n";
+    }
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("hough_line");
+    return 0;
+}
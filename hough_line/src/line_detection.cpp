@@ -0,0 +1,85 @@
+/**
+ * @file line_detection.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The line detection from an image, the Canny edges are passed to the Hough transform as a list of pixels.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <iostream>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "buffer_pool/buffer_pool.hpp"
+#include "canny_edge_detection/canny_edge_detection.hpp"
+#include "hough_line/hough_line.hpp"
+#include "instrumentation/instrumentation.hpp"
+
+/**
+ * @brief Get the time elapsed since a tick count.
+ * 
+ * @param[in] start The tick count at the start.
+ * @return The elapsed time in milliseconds.
+ * @since 0.0.2
+ */
+static double get_elapsed_time(const int64& start)
+{
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+/**
+ * @brief The main function.
+ * 
+ * @param[in] argc The argument count.
+ * @param[in] argv The argument vector.
+ * @return The status value.
+ * @since 0.0.2
+ */
+int main(int argc, char** argv)
+{
+    start_instrumentation();
+    install_buffer_pool();
+
+    if (argc != 2)
+    {
+        printf("To run the line detection, type ./line_detection <image_file>\n");
+        return 1;
+    }
+    cv::Mat image = cv::imread(argv[1], 0);
+    if (image.empty())
+    {
+        printf("The input image is empty.\n");
+        return 1;
+    }
+
+    // Detect the edges straight into a list of pixels with their gradient orientations
+    std::vector<cv::Point> points;
+    std::vector<float> orientations;
+    int64 start = cv::getTickCount();
+    detect_edge_points(image, points, &orientations);
+    double edge_time = get_elapsed_time(start);
+
+    // Vote for every theta as the reference, then only around the gradient orientations
+    HoughLine hough_line(M_PI / 180, 100, 10, M_PI / 18, M_PI / 36);
+    start = cv::getTickCount();
+    std::vector<Line> reference_lines = hough_line.detect_lines(points, image.size());
+    double reference_time = get_elapsed_time(start);
+    start = cv::getTickCount();
+    std::vector<Line> lines = hough_line.detect_lines(points, orientations, image.size());
+    double oriented_time = get_elapsed_time(start);
+
+    printf("Edges: %zu pixels, %.3f ms\n", points.size(), edge_time);
+    printf("Every theta: %zu lines, %.3f ms\n", reference_lines.size(), reference_time);
+    printf("Around the gradient orientation: %zu lines, %.3f ms (%.2fx)\n",
+           lines.size(), oriented_time, reference_time / oriented_time);
+    for (size_t i = 0; i < lines.size(); ++i)
+    {
+        std::cout << "(rho, theta) = (" << lines[i].rho << ", " << lines[i].theta << ")\n";
+    }
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("line_detection");
+    return 0;
+}
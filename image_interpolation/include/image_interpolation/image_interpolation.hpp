@@ -0,0 +1,55 @@
+/**
+ * @file image_interpolation.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The image interpolation implementation.
+ * @since 0.0.1
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef IMAGE_INTERPOLATION_IMAGE_INTERPOLATION_HPP
+#define IMAGE_INTERPOLATION_IMAGE_INTERPOLATION_HPP
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief The interpolation methods.
+ * 
+ * @since 0.0.1
+ * 
+ */
+enum Method : uchar
+{
+    NEAREST = 0,
+    BILINEAR = 1,
+    BICUBIC = 2
+};
+
+/**
+ * @brief The interpolation fuction for 1D data.
+ * 
+ * @param[in] point_0 The pixel value of the first point.
+ * @param[in] point_1 The pixel value of the second point.
+ * @param[in] point_2 The pixel value of the third point.
+ * @param[in] point_3 The pixel value of the fourth point.
+ * @param[in] x The position of the interpolation point.
+ * @return The interpolated value.
+ * @since 0.0.1
+ */
+uchar get_cubic_interpolation(uchar point_0, uchar point_1, uchar point_2, uchar point_3, float x);
+
+/**
+ * @brief The resize image function.
+ * 
+ * @param[in] source The input image.
+ * @param[out] destination The resized image.
+ * @param[in] size The desired resolution.
+ * @param[in] method The interpolation method.
+ * @since 0.0.1
+ */
+void resize_image(const cv::Mat& source,
+                  cv::Mat& destination,
+                  const cv::Size& size, Method method = BILINEAR);
+
+#endif // IMAGE_INTERPOLATION_IMAGE_INTERPOLATION_HPP
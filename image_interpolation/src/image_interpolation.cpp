@@ -1,5 +1,5 @@
 /**
- * @file sudoku_detection.cpp
+ * @file image_interpolation.cpp
  * @author Nguyen Quang <nqoptik@gmail.com>
  * @brief The image interpolation implementation.
  * @since 0.0.1
@@ -8,23 +8,11 @@
  * 
  */
 
-#include <iostream>
+#include "image_interpolation/image_interpolation.hpp"
 
-#include <opencv2/core/core.hpp>
-#include <opencv2/highgui/highgui.hpp>
+#include <cmath>
 
-/**
- * @brief The interpolation methods.
- * 
- * @since 0.0.1
- * 
- */
-enum Method : uchar
-{
-    NEAREST = 0,
-    BILINEAR = 1,
-    BICUBIC = 2
-};
+#include "instrumentation/instrumentation.hpp"
 
 /**
  * @brief The pixel struct.
@@ -42,17 +30,9 @@ struct Pixel
     }
 };
 
-/**
- * @brief The interpolation fuction for 1D data.
- * 
- * @param[in] point_0 The pixel value of the first point.
- * @param[in] point_1 The pixel value of the second point.
- * @param[in] point_2 The pixel value of the third point.
- * @param[in] point_3 The pixel value of the fourth point.
- * @param[in] x The position of the interpolation point.
- * @return The interpolated value.
- * @since 0.0.1
- */
+// The pixel map is stored in a CV_32FC2 cv::Mat
+static_assert(sizeof(Pixel) == 2 * sizeof(float), "A pixel has to be two packed floats");
+
 uchar get_cubic_interpolation(uchar point_0, uchar point_1, uchar point_2, uchar point_3, float x)
 {
     float a = -0.5 * point_0 + 1.5 * point_1 - 1.5 * point_2 + 0.5 * point_3;
@@ -71,30 +51,24 @@ uchar get_cubic_interpolation(uchar point_0, uchar point_1, uchar point_2, uchar
     return value;
 }
 
-/**
- * @brief The resize image function.
- * 
- * @param[in] source The input image.
- * @param[out] destination The resized image.
- * @param[in] size The desired resolution.
- * @param[in] method The interpolation method.
- * @since 0.0.1
- */
 void resize_image(const cv::Mat& source,
                   cv::Mat& destination,
-                  const cv::Size& size, Method method = BILINEAR)
+                  const cv::Size& size, Method method)
 {
-    // Calculate the map from source image to destination image
-    std::vector<Pixel> pixel_map;
+    CVBASIC_SCOPED_TIMER("resize_image");
+    CVBASIC_COUNT(PIXELS_PROCESSED, (uint64_t)size.area());
+
+    // Calculate the map from source image to destination image, in a cv::Mat so its buffer is pooled like a frame
+    cv::Mat pixel_map_buffer(size, CV_32FC2);
+    Pixel* pixel_map = pixel_map_buffer.ptr<Pixel>();
     size_t map_size = size.width * size.height;
-    pixel_map.reserve(map_size);
     for (size_t i = 0; i < map_size; ++i)
     {
         int column_new = i % size.width;
         int row_new = i / size.width;
         float column = ((float)(source.cols) / (size.width) * (column_new + 0.5)) - 0.5;
         float row = ((float)(source.rows) / (size.height) * (row_new + 0.5)) - 0.5;
-        pixel_map.emplace_back(Pixel(column, row));
+        pixel_map[i] = Pixel(column, row);
     }
 
     // Create storage for the destination image
@@ -310,57 +284,3 @@ void resize_image(const cv::Mat& source,
         }
     }
 }
-
-/**
- * @brief The main function.
- * 
- * @param[in] argc The argument count.
- * @param[in] argv The argument vector.
- * @return The status value.
- * @since 0.0.1
- */
-int main(int argc, char** argv)
-{
-    if (argc != 3)
-    {
-        printf("To run the image interpolation, type ./image_interpolation <image_file> <scale>\n");
-        return 1;
-    }
-
-    // Read the image
-    cv::Mat image = cv::imread(argv[1]);
-    if (image.empty())
-    {
-        printf("The input image is empty.\n");
-        return 1;
-    }
-
-    // Get the destination size
-    std::string ratio_string = argv[2];
-    float ratio = std::stoi(ratio_string);
-    if (ratio <= 0)
-    {
-        printf("Ratio has to be greater than 0\n");
-    }
-    cv::Size destination_size(image.cols * ratio, image.rows * ratio);
-
-    // Nearest neighbour interpolation
-    cv::Mat resized_image_nearest;
-    resize_image(image, resized_image_nearest, destination_size, NEAREST);
-
-    // Bilinear interpolation
-    cv::Mat resized_image_bilinear;
-    resize_image(image, resized_image_bilinear, destination_size, BILINEAR);
-
-    // Bicubic interpolation
-    cv::Mat resized_image_bicubic;
-    resize_image(image, resized_image_bicubic, destination_size, BICUBIC);
-
-    // Display the images
-    cv::imshow("image", image);
-    cv::imshow("resized_image_nearest", resized_image_nearest);
-    cv::imshow("resized_image_bilinear", resized_image_bilinear);
-    cv::imshow("resized_image_bicubic", resized_image_bicubic);
-    cv::waitKey(0);
-    return 0;
-}
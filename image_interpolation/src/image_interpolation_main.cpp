@@ -0,0 +1,77 @@
+/**
+ * @file image_interpolation_main.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief Resize an image with every interpolation method.
+ * @since 0.0.1
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <iostream>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+#include "buffer_pool/buffer_pool.hpp"
+#include "image_interpolation/image_interpolation.hpp"
+#include "instrumentation/instrumentation.hpp"
+
+/**
+ * @brief The main function.
+ * 
+ * @param[in] argc The argument count.
+ * @param[in] argv The argument vector.
+ * @return The status value.
+ * @since 0.0.1
+ */
+int main(int argc, char** argv)
+{
+    start_instrumentation();
+    install_buffer_pool();
+
+    if (argc != 3)
+    {
+        printf("To run the image interpolation, type ./image_interpolation <image_file> <scale>\n");
+        return 1;
+    }
+
+    // Read the image
+    cv::Mat image = cv::imread(argv[1]);
+    if (image.empty())
+    {
+        printf("The input image is empty.\n");
+        return 1;
+    }
+
+    // Get the destination size
+    std::string ratio_string = argv[2];
+    float ratio = std::stoi(ratio_string);
+    if (ratio <= 0)
+    {
+        printf("Ratio has to be greater than 0\n");
+    }
+    cv::Size destination_size(image.cols * ratio, image.rows * ratio);
+
+    // Nearest neighbour interpolation
+    cv::Mat resized_image_nearest;
+    resize_image(image, resized_image_nearest, destination_size, NEAREST);
+
+    // Bilinear interpolation
+    cv::Mat resized_image_bilinear;
+    resize_image(image, resized_image_bilinear, destination_size, BILINEAR);
+
+    // Bicubic interpolation
+    cv::Mat resized_image_bicubic;
+    resize_image(image, resized_image_bicubic, destination_size, BICUBIC);
+
+    // Display the images
+    cv::imshow("image", image);
+    cv::imshow("resized_image_nearest", resized_image_nearest);
+    cv::imshow("resized_image_bilinear", resized_image_bilinear);
+    cv::imshow("resized_image_bicubic", resized_image_bicubic);
+    cv::waitKey(0);
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("image_interpolation");
+    return 0;
+}
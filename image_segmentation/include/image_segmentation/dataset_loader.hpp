@@ -0,0 +1,137 @@
+/**
+ * @file dataset_loader.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The loader of the sample images, decoding ahead of the segmentation on worker threads.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef IMAGE_SEGMENTATION_DATASET_LOADER_HPP
+#define IMAGE_SEGMENTATION_DATASET_LOADER_HPP
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+
+/**
+ * @brief A decoded image of a dataset.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct DatasetImage
+{
+    size_t index;     //!< The index of the image in the sorted paths.
+    std::string path; //!< The path of the image.
+    cv::Mat image;    //!< The decoded image, empty if the file cannot be decoded.
+};
+
+/**
+ * @brief A class to decode the images of a dataset ahead of their processing.
+ * 
+ * The workers decode the images in parallel, at most prefetch_depth images ahead of the consumer, and the images
+ * are returned in the order of their paths. The files that cannot be decoded are skipped and reported.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class DatasetLoader
+{
+private:
+    std::vector<std::string> paths_;       //!< The paths of the images.
+    int flags_;                            //!< The cv::imread flags.
+    int reduction_;                        //!< The factor the images are downscaled by.
+    size_t prefetch_depth_;                //!< The maximum number of images decoded ahead of the consumer.
+    size_t next_claimed_;                  //!< The index of the next image to decode.
+    size_t next_returned_;                 //!< The index of the next image to return.
+    bool stopped_;                         //!< Whether the workers have to stop.
+    std::map<size_t, DatasetImage> ready_; //!< The decoded images waiting for the consumer, by index.
+    std::vector<std::string> failures_;    //!< The paths of the files that cannot be decoded.
+    std::mutex mutex_;                     //!< The lock of the state shared with the workers.
+    std::condition_variable decoded_;      //!< Signalled when an image is decoded.
+    std::condition_variable returned_;     //!< Signalled when an image is returned or the workers have to stop.
+    std::vector<std::thread> workers_;     //!< The decoding threads.
+
+    /**
+     * @brief Decode the images claimed by a worker until there is no image left or the loader stops.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    void decode_images();
+
+    /**
+     * @brief Decode an image.
+     * 
+     * @param[in] path The path of the image.
+     * @return The image, empty if the file cannot be decoded.
+     * @since 0.0.2
+     */
+    cv::Mat decode_image(const std::string& path) const;
+
+public:
+    /**
+     * @brief Construct a new DatasetLoader object and start decoding.
+     * 
+     * @param[in] paths The paths of the images, in the order they are returned.
+     * @param[in] flags The cv::imread flags.
+     * @param[in] reduction The factor to downscale the images by, 2, 4 and 8 are decoded at the reduced size
+     * directly when the codec supports it.
+     * @param[in] number_of_workers The number of decoding threads.
+     * @param[in] prefetch_depth The maximum number of images decoded ahead of the consumer.
+     * @since 0.0.2
+     */
+    explicit DatasetLoader(const std::vector<std::string>& paths,
+                           const int& flags = cv::IMREAD_COLOR,
+                           const int& reduction = 1,
+                           const int& number_of_workers = 2,
+                           const size_t& prefetch_depth = 4);
+
+    /**
+     * @brief Destroy the DatasetLoader object, the workers are stopped.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~DatasetLoader();
+
+    DatasetLoader(const DatasetLoader&) = delete;
+    DatasetLoader& operator=(const DatasetLoader&) = delete;
+
+    /**
+     * @brief Get the next image that can be decoded, waiting for it if it is not decoded yet.
+     * 
+     * @param[out] image The next image.
+     * @return Whether there is an image, false at the end of the dataset.
+     * @since 0.0.2
+     */
+    bool next(DatasetImage& image);
+
+    /**
+     * @brief Get the paths of the files skipped so far because they cannot be decoded.
+     * 
+     * @return The paths, in the order of the dataset.
+     * @since 0.0.2
+     */
+    std::vector<std::string> failures();
+};
+
+/**
+ * @brief List the files of a directory.
+ * 
+ * @param[in] directory The directory, with a trailing slash.
+ * @param[out] paths The sorted paths of the files.
+ * @return Whether the directory can be read.
+ * @since 0.0.2
+ */
+bool list_directory(const std::string& directory, std::vector<std::string>& paths);
+
+#endif // IMAGE_SEGMENTATION_DATASET_LOADER_HPP
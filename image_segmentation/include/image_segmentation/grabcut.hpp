@@ -0,0 +1,206 @@
+/**
+ * @file grabcut.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The coarse-to-fine GrabCut segmentation.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef IMAGE_SEGMENTATION_GRABCUT_HPP
+#define IMAGE_SEGMENTATION_GRABCUT_HPP
+
+#include <string>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief A class to keep the GrabCut color models of a segmentation so that they can be reused.
+ * 
+ * Learning the models from scratch clusters every pixel of the image. The models can instead carry over when the
+ * same image is refined with more strokes or when a similar image, like the next frame of a video, is segmented.
+ * They are then only re-estimated from the current mask by cv::GC_EVAL.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class GrabCutModel
+{
+private:
+    cv::Mat background_model_; //!< The background color model in the layout of cv::grabCut.
+    cv::Mat foreground_model_; //!< The foreground color model in the layout of cv::grabCut.
+    double learning_time_;     //!< The time in milliseconds it took to learn the models from scratch.
+    double saved_time_;        //!< The learning time in milliseconds saved by reusing the models.
+
+public:
+    /**
+     * @brief Construct a new GrabCutModel object without models.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    GrabCutModel();
+
+    /**
+     * @brief Destroy the GrabCutModel object.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~GrabCutModel();
+
+    /**
+     * @brief Check whether there are models to reuse.
+     * 
+     * @return True if the models have not been learned or loaded yet, false otherwise.
+     * @since 0.0.2
+     */
+    bool empty() const;
+
+    /**
+     * @brief Drop the models so that the next segmentation learns them from scratch.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    void clear();
+
+    /**
+     * @brief Learn the models from scratch and measure the learning time.
+     * 
+     * @param[in] image The 8-bit 3-channel image.
+     * @param[in] mask The 8-bit single-channel mask of cv::GrabCutClasses with both background and foreground pixels.
+     * @since 0.0.2
+     */
+    void learn(const cv::Mat& image, const cv::Mat& mask);
+
+    /**
+     * @brief Segment an image, the models are learned first if there are none and reused otherwise.
+     * 
+     * @param[in] image The 8-bit 3-channel image.
+     * @param[in,out] mask The 8-bit single-channel mask of cv::GrabCutClasses.
+     * @param[in] iterations The number of GrabCut iterations.
+     * @since 0.0.2
+     */
+    void segment(const cv::Mat& image, cv::Mat& mask, const int& iterations);
+
+    /**
+     * @brief Get the background color model.
+     * 
+     * @return The background color model in the layout of cv::grabCut.
+     * @since 0.0.2
+     */
+    const cv::Mat& background_model() const;
+
+    /**
+     * @brief Get the foreground color model.
+     * 
+     * @return The foreground color model in the layout of cv::grabCut.
+     * @since 0.0.2
+     */
+    const cv::Mat& foreground_model() const;
+
+    /**
+     * @brief Get the time it took to learn the models from scratch.
+     * 
+     * @return The learning time in milliseconds.
+     * @since 0.0.2
+     */
+    double learning_time() const;
+
+    /**
+     * @brief Get the learning time saved by reusing the models, every reuse saves one learning time.
+     * 
+     * @return The saved time in milliseconds.
+     * @since 0.0.2
+     */
+    double saved_time() const;
+
+    /**
+     * @brief Save the models and their learning time to a file.
+     * 
+     * @param[in] path The path of the file, its extension selects the format of cv::FileStorage.
+     * @return False if there are no models or the file cannot be written, true otherwise.
+     * @since 0.0.2
+     */
+    bool save(const std::string& path) const;
+
+    /**
+     * @brief Load the models and their learning time from a file written by save.
+     * 
+     * @param[in] path The path of the file.
+     * @return False if the file cannot be read or does not hold valid models, true otherwise.
+     * @since 0.0.2
+     */
+    bool load(const std::string& path);
+};
+
+/**
+ * @brief A class to segment an image with GrabCut at a low resolution and refine the boundary at full resolution.
+ * 
+ * The color models are learned or reused and the graph cut is first solved on a downscaled image. The coarse mask is upsampled and
+ * every pixel further than the band width from the coarse boundary is fixed. The pixels inside the band are then
+ * solved again at full resolution with the learned models, tile by tile, so the full resolution graphs only cover
+ * the band around the boundary.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class MultiResolutionGrabCut
+{
+private:
+    double scale_;   //!< The downscale factor of the coarse level, 1 to run GrabCut at full resolution only.
+    int band_width_; //!< The half width in pixels of the band around the coarse boundary that is solved again.
+    int iterations_; //!< The number of GrabCut iterations at the coarse level.
+    int tile_size_;  //!< The size of the tiles the band is solved in at full resolution.
+
+public:
+    /**
+     * @brief Construct a new MultiResolutionGrabCut object.
+     * 
+     * @param[in] scale The downscale factor of the coarse level, 1 to run GrabCut at full resolution only.
+     * @param[in] band_width The half width in pixels of the band around the coarse boundary that is solved again.
+     * @param[in] iterations The number of GrabCut iterations at the coarse level.
+     * @param[in] tile_size The size of the tiles the band is solved in at full resolution.
+     * @since 0.0.2
+     */
+    MultiResolutionGrabCut(const double& scale = 4,
+                           const int& band_width = 8,
+                           const int& iterations = 1,
+                           const int& tile_size = 128);
+
+    /**
+     * @brief Destroy the MultiResolutionGrabCut object.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~MultiResolutionGrabCut();
+
+    /**
+     * @brief Segment an image from a mask, like cv::grabCut with cv::GC_INIT_WITH_MASK or cv::GC_EVAL.
+     * 
+     * @param[in] image The 8-bit 3-channel image.
+     * @param[in,out] mask The 8-bit single-channel mask of cv::GrabCutClasses. The definite pixels are kept and
+     * every other pixel is set to cv::GC_PR_BGD or cv::GC_PR_FGD.
+     * @param[in,out] model The color models, they are learned at the coarse level if there are none.
+     * @since 0.0.2
+     */
+    void segment(const cv::Mat& image, cv::Mat& mask, GrabCutModel& model) const;
+};
+
+/**
+ * @brief Get the boundary IoU between two binary masks.
+ * 
+ * The boundary of a mask is the set of its foreground pixels within the given distance from the background.
+ * 
+ * @param[in] mask_0 The first 8-bit single-channel mask, non-zero pixels are foreground.
+ * @param[in] mask_1 The second 8-bit single-channel mask, non-zero pixels are foreground.
+ * @param[in] distance The width of the boundaries in pixels.
+ * @return The intersection over union of the boundaries, 1 if both boundaries are empty.
+ * @since 0.0.2
+ */
+double get_boundary_iou(const cv::Mat& mask_0, const cv::Mat& mask_1, const int& distance);
+
+#endif // IMAGE_SEGMENTATION_GRABCUT_HPP
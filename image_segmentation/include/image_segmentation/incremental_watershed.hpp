@@ -0,0 +1,95 @@
+/**
+ * @file incremental_watershed.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The watershed segmentation that is updated incrementally when scribbles are added.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef IMAGE_SEGMENTATION_INCREMENTAL_WATERSHED_HPP
+#define IMAGE_SEGMENTATION_INCREMENTAL_WATERSHED_HPP
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+#include "image_segmentation/watershed.hpp"
+
+/**
+ * @brief A class to keep a watershed segmentation up to date while the user adds scribbles.
+ * 
+ * Every scribble gets a new label and absorbs the seeds it touches. Only the basins of the absorbed seeds and
+ * the basins the scribble is drawn on are cleared and flooded again from their surroundings, so the cost of an
+ * update depends on the size of the edited basins instead of the size of the image. Basins that are not touched
+ * keep their labels, so the result can differ from a full segmentation where a new seed would have won pixels
+ * of a neighbouring basin.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class IncrementalWatershed
+{
+private:
+    Watershed watershed_;                  //!< The watershed transform.
+    cv::Mat image_;                        //!< The segmented 8-bit 3-channel image.
+    cv::Mat seeds_;                        //!< The seed label of every pixel, 0 where there is no seed.
+    cv::Mat labels_;                       //!< The current basin label of every pixel.
+    std::vector<cv::Rect> bounding_boxes_; //!< The bounding box of every basin, indexed by label.
+    int number_of_labels_;                 //!< The largest label in use.
+
+public:
+    /**
+     * @brief Construct a new IncrementalWatershed object.
+     * 
+     * @param[in] number_of_tiles The number of tiles of the initial full segmentation.
+     * @since 0.0.2
+     */
+    explicit IncrementalWatershed(const int& number_of_tiles = 1);
+
+    /**
+     * @brief Destroy the IncrementalWatershed object.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~IncrementalWatershed();
+
+    /**
+     * @brief Segment a new image from scratch.
+     * 
+     * @param[in] image The 8-bit 3-channel input image.
+     * @param[in] seeds The 32-bit single-channel seeds, positive values are seed labels.
+     * @since 0.0.2
+     */
+    void reset(const cv::Mat& image, const cv::Mat& seeds);
+
+    /**
+     * @brief Add a scribble as a new seed and update the affected basins.
+     * 
+     * @param[in] scribble The pixels of the scribble.
+     * @param[out] changed_pixels The offsets of the pixels whose label changed.
+     * @return The label of the scribble, 0 if the scribble has no pixel inside the image.
+     * @since 0.0.2
+     */
+    int add_scribble(const std::vector<cv::Point>& scribble, std::vector<int>& changed_pixels);
+
+    /**
+     * @brief Get the current labels.
+     * 
+     * @return The 32-bit single-channel labels, -1 on the watershed lines.
+     * @since 0.0.2
+     */
+    const cv::Mat& labels() const;
+
+    /**
+     * @brief Get the largest label in use.
+     * 
+     * @return The largest label.
+     * @since 0.0.2
+     */
+    int number_of_labels() const;
+};
+
+#endif // IMAGE_SEGMENTATION_INCREMENTAL_WATERSHED_HPP
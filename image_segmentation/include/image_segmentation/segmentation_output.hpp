@@ -0,0 +1,135 @@
+/**
+ * @file segmentation_output.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The output stage of the segmentation tools: color overlays, alpha blends, cutouts and run-length masks.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef IMAGE_SEGMENTATION_SEGMENTATION_OUTPUT_HPP
+#define IMAGE_SEGMENTATION_SEGMENTATION_OUTPUT_HPP
+
+#include <iostream>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief A binary mask stored as the lengths of alternating background and foreground runs.
+ * 
+ * The runs follow the row-major order of the pixels and may cross rows. The first run is background and may be
+ * empty, so the runs at odd indices are foreground.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct RunLengthMask
+{
+    int rows;               //!< The number of rows of the mask.
+    int cols;               //!< The number of columns of the mask.
+    std::vector<int> runs;  //!< The lengths of the alternating runs, starting with background.
+};
+
+/**
+ * @brief Make a lookup table with a random color for every label.
+ * 
+ * The entry 0 is black, it is used for the label 0, the watershed lines and the labels out of the table.
+ * 
+ * @param[in] number_of_labels The largest label.
+ * @param[in,out] rng The random number generator.
+ * @return The lookup table with number_of_labels + 1 entries.
+ * @since 0.0.2
+ */
+std::vector<cv::Vec3b> make_label_colors(const int& number_of_labels, cv::RNG& rng = cv::theRNG());
+
+/**
+ * @brief Color every pixel of a label image through a lookup table.
+ * 
+ * @param[in] labels The 8-bit or 32-bit single-channel labels.
+ * @param[in] colors The lookup table, labels out of the table take the entry 0.
+ * @param[out] output The 8-bit 3-channel color image.
+ * @since 0.0.2
+ */
+void color_labels(const cv::Mat& labels, const std::vector<cv::Vec3b>& colors, cv::Mat& output);
+
+/**
+ * @brief Color the given pixels of a label image through a lookup table, the other pixels are left untouched.
+ * 
+ * @param[in] labels The continuous 32-bit single-channel labels.
+ * @param[in] colors The lookup table, labels out of the table take the entry 0.
+ * @param[in] pixels The offsets of the pixels to color.
+ * @param[in,out] output The continuous 8-bit 3-channel color image of the same size as the labels.
+ * @since 0.0.2
+ */
+void color_labels(const cv::Mat& labels, const std::vector<cv::Vec3b>& colors,
+                  const std::vector<int>& pixels, cv::Mat& output);
+
+/**
+ * @brief Blend the colors of the labels over an image.
+ * 
+ * Pixels whose label takes the entry 0 of the lookup table keep the image color.
+ * 
+ * @param[in] image The 8-bit 3-channel image.
+ * @param[in] labels The 8-bit or 32-bit single-channel labels.
+ * @param[in] colors The lookup table, labels out of the table take the entry 0.
+ * @param[in] alpha The opacity of the label colors in the range [0, 1].
+ * @param[out] output The 8-bit 3-channel blended image.
+ * @since 0.0.2
+ */
+void blend_labels(const cv::Mat& image, const cv::Mat& labels, const std::vector<cv::Vec3b>& colors,
+                  const float& alpha, cv::Mat& output);
+
+/**
+ * @brief Cut the foreground out of an image, the background becomes black.
+ * 
+ * @param[in] image The 8-bit 3-channel image.
+ * @param[in] mask The 8-bit single-channel mask.
+ * @param[in] foreground_bits The mask bits of the foreground, a pixel is foreground if any of them is set, e.g. 1
+ * for the definite and probable foreground of a GrabCut mask.
+ * @param[out] output The 8-bit 3-channel cutout.
+ * @since 0.0.2
+ */
+void cut_out(const cv::Mat& image, const cv::Mat& mask, const uchar& foreground_bits, cv::Mat& output);
+
+/**
+ * @brief Encode the foreground of a mask into runs.
+ * 
+ * @param[in] mask The 8-bit single-channel mask.
+ * @param[in] foreground_bits The mask bits of the foreground, a pixel is foreground if any of them is set.
+ * @param[out] encoded The run-length mask.
+ * @since 0.0.2
+ */
+void encode_run_length(const cv::Mat& mask, const uchar& foreground_bits, RunLengthMask& encoded);
+
+/**
+ * @brief Decode a run-length mask.
+ * 
+ * @param[in] encoded The run-length mask.
+ * @param[out] mask The 8-bit single-channel mask, 255 for the foreground and 0 for the background.
+ * @since 0.0.2
+ */
+void decode_run_length(const RunLengthMask& encoded, cv::Mat& mask);
+
+/**
+ * @brief Write a run-length mask to a binary stream, the runs are stored as variable-length integers.
+ * 
+ * @param[in] encoded The run-length mask.
+ * @param[out] stream The output stream.
+ * @return The number of bytes written.
+ * @since 0.0.2
+ */
+size_t write_run_length(const RunLengthMask& encoded, std::ostream& stream);
+
+/**
+ * @brief Read a run-length mask written by write_run_length.
+ * 
+ * @param[in] stream The input stream.
+ * @param[out] encoded The run-length mask.
+ * @return False if the stream does not hold a valid run-length mask, true otherwise.
+ * @since 0.0.2
+ */
+bool read_run_length(std::istream& stream, RunLengthMask& encoded);
+
+#endif // IMAGE_SEGMENTATION_SEGMENTATION_OUTPUT_HPP
@@ -0,0 +1,179 @@
+/**
+ * @file watershed.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The priority-flood watershed transform for marker based segmentation.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef IMAGE_SEGMENTATION_WATERSHED_HPP
+#define IMAGE_SEGMENTATION_WATERSHED_HPP
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief A priority queue of pixel offsets with 256 FIFO buckets keyed on an 8-bit priority.
+ * 
+ * The buckets are intrusive linked lists threaded through an external links array with one entry per pixel,
+ * so push and pop are O(1) and the queue never allocates. A pixel must not be pushed twice before it is popped.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class BucketQueue
+{
+public:
+    static const int NUMBER_OF_BUCKETS = 256; //!< The number of priority levels.
+
+private:
+    int* links_;                     //!< The next pixel offset in the same bucket, indexed by pixel offset.
+    int heads_[NUMBER_OF_BUCKETS];   //!< The first pixel offset of every bucket, -1 if the bucket is empty.
+    int tails_[NUMBER_OF_BUCKETS];   //!< The last pixel offset of every bucket, -1 if the bucket is empty.
+    int active_bucket_;              //!< The lowest bucket that may be non-empty.
+
+public:
+    /**
+     * @brief Construct a new BucketQueue object.
+     * 
+     * @param[in] links The links array, it must hold at least one entry for every pixel offset pushed.
+     * @since 0.0.2
+     */
+    explicit BucketQueue(int* links);
+
+    /**
+     * @brief Push a pixel offset into the bucket of the given priority.
+     * 
+     * @param[in] priority The priority in the range [0, 255], lower values are popped first.
+     * @param[in] offset The pixel offset.
+     * @since 0.0.2
+     */
+    void push(const int& priority, const int& offset)
+    {
+        links_[offset] = -1;
+        if (tails_[priority] < 0)
+        {
+            heads_[priority] = offset;
+        }
+        else
+        {
+            links_[tails_[priority]] = offset;
+        }
+        tails_[priority] = offset;
+        if (priority < active_bucket_)
+        {
+            active_bucket_ = priority;
+        }
+    }
+
+    /**
+     * @brief Pop the oldest pixel offset of the lowest non-empty bucket.
+     * 
+     * @param[out] offset The pixel offset.
+     * @return False if the queue is empty, true otherwise.
+     * @since 0.0.2
+     */
+    bool pop(int& offset)
+    {
+        while (heads_[active_bucket_] < 0)
+        {
+            if (++active_bucket_ == NUMBER_OF_BUCKETS)
+            {
+                active_bucket_ = NUMBER_OF_BUCKETS - 1;
+                return false;
+            }
+        }
+        offset = heads_[active_bucket_];
+        heads_[active_bucket_] = links_[offset];
+        if (heads_[active_bucket_] < 0)
+        {
+            tails_[active_bucket_] = -1;
+        }
+        return true;
+    }
+};
+
+/**
+ * @brief A class to segment an image with the marker based watershed transform.
+ * 
+ * The flooding follows cv::watershed: the priority of a pixel is the maximum absolute channel difference to the
+ * neighbour it was reached from, labels spread over the 4-neighbourhood, and pixels that touch two different
+ * labels become watershed lines (-1). The sequential mode reproduces the labels of cv::watershed exactly.
+ * The tiled mode floods horizontal strips in parallel, then clears a band around every seam and refloods it
+ * from the surrounding labels, so the result may differ from the sequential one close to the seams.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class Watershed
+{
+public:
+    static const int WATERSHED_LINE = -1; //!< The label of the watershed lines and of the image border.
+
+private:
+    int number_of_tiles_;   //!< The number of horizontal strips flooded in parallel, 1 for the sequential mode.
+    int seam_band_;         //!< The half height of the band around every seam that is reflooded after the tiles.
+    std::vector<int> links_; //!< The links array shared by all bucket queues, one entry per pixel.
+
+public:
+    /**
+     * @brief Construct a new Watershed object.
+     * 
+     * @param[in] number_of_tiles The number of horizontal strips flooded in parallel, 1 for the sequential mode.
+     * @param[in] seam_band The half height of the band around every seam that is reflooded after the tiles.
+     * @since 0.0.2
+     */
+    Watershed(const int& number_of_tiles = 1,
+              const int& seam_band = 16);
+
+    /**
+     * @brief Destroy the Watershed object.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~Watershed();
+
+    /**
+     * @brief Segment the image from the given markers, like cv::watershed.
+     * 
+     * @param[in] image The 8-bit 3-channel input image.
+     * @param[in,out] markers The continuous 32-bit single-channel markers, positive values are seeds.
+     * On return every pixel holds its basin label or -1 on the watershed lines and the image border.
+     * @since 0.0.2
+     */
+    void segment(const cv::Mat& image, cv::Mat& markers);
+
+    /**
+     * @brief Flood the unlabelled pixels of a region from the labels around it.
+     * 
+     * Only pixels of the region whose label is 0 are flooded, labels outside the region are read but never changed,
+     * and watershed lines are kept. The markers have to be the output of a previous segmentation.
+     * 
+     * @param[in] image The 8-bit 3-channel input image.
+     * @param[in,out] markers The continuous 32-bit single-channel labels.
+     * @param[in] region The region to flood, clipped to the image interior.
+     * @since 0.0.2
+     */
+    void reflood(const cv::Mat& image, cv::Mat& markers, const cv::Rect& region);
+
+private:
+    /**
+     * @brief Flood the unlabelled pixels inside a region with a single bucket queue.
+     * 
+     * @param[in] image The continuous 8-bit 3-channel input image.
+     * @param[in,out] markers The continuous 32-bit single-channel labels.
+     * @param[in] region The region whose unlabelled pixels seed the queue, inside the image interior.
+     * @param[in] offset_begin The first pixel offset that may be read or labelled.
+     * @param[in] offset_end The pixel offset past the last one that may be read or labelled.
+     * @param[in] reset_negative Whether negative labels inside the region are cleared before flooding.
+     * @since 0.0.2
+     */
+    void flood(const cv::Mat& image, cv::Mat& markers, const cv::Rect& region,
+               const int& offset_begin, const int& offset_end, const bool& reset_negative);
+};
+
+#endif // IMAGE_SEGMENTATION_WATERSHED_HPP
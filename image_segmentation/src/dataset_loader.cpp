@@ -0,0 +1,197 @@
+/**
+ * @file dataset_loader.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The loader of the sample images, decoding ahead of the segmentation on worker threads.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "image_segmentation/dataset_loader.hpp"
+
+#include <dirent.h>
+#include <algorithm>
+#include <cstring>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "instrumentation/instrumentation.hpp"
+
+// The codecs can decode at a half, a quarter or an eighth of the size since OpenCV 3.2
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 2)
+#define HAVE_IMREAD_REDUCED
+#endif
+
+/**
+ * @brief Get the cv::imread flags that decode an image at a reduced size.
+ * 
+ * @param[in] flags The cv::imread flags at the full size.
+ * @param[in] reduction The factor to downscale the image by.
+ * @return The flags, -2 if the codec cannot decode at this reduced size.
+ * @since 0.0.2
+ */
+static int get_reduced_flags(const int& flags, const int& reduction)
+{
+#ifdef HAVE_IMREAD_REDUCED
+    if (flags == cv::IMREAD_COLOR || flags == cv::IMREAD_GRAYSCALE)
+    {
+        bool color = flags == cv::IMREAD_COLOR;
+        switch (reduction)
+        {
+        case 2:
+            return color ? cv::IMREAD_REDUCED_COLOR_2 : cv::IMREAD_REDUCED_GRAYSCALE_2;
+        case 4:
+            return color ? cv::IMREAD_REDUCED_COLOR_4 : cv::IMREAD_REDUCED_GRAYSCALE_4;
+        case 8:
+            return color ? cv::IMREAD_REDUCED_COLOR_8 : cv::IMREAD_REDUCED_GRAYSCALE_8;
+        default:
+            break;
+        }
+    }
+#else
+    (void)flags;
+    (void)reduction;
+#endif
+    return -2;
+}
+
+DatasetLoader::DatasetLoader(const std::vector<std::string>& paths,
+                             const int& flags,
+                             const int& reduction,
+                             const int& number_of_workers,
+                             const size_t& prefetch_depth)
+    : paths_(paths),
+      flags_(flags),
+      reduction_(std::max(reduction, 1)),
+      prefetch_depth_(std::max(prefetch_depth, (size_t)1)),
+      next_claimed_(0),
+      next_returned_(0),
+      stopped_(false)
+{
+    for (int worker_index = 0; worker_index < std::max(number_of_workers, 1); ++worker_index)
+    {
+        workers_.push_back(std::thread(&DatasetLoader::decode_images, this));
+    }
+}
+
+DatasetLoader::~DatasetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    returned_.notify_all();
+    for (size_t worker_index = 0; worker_index < workers_.size(); ++worker_index)
+    {
+        workers_[worker_index].join();
+    }
+}
+
+void DatasetLoader::decode_images()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        // Stay at most prefetch_depth_ images ahead of the consumer, so the decoded images are bounded
+        returned_.wait(lock, [this] {
+            return stopped_ || next_claimed_ >= paths_.size() || next_claimed_ < next_returned_ + prefetch_depth_;
+        });
+        if (stopped_ || next_claimed_ >= paths_.size())
+        {
+            return;
+        }
+        size_t index = next_claimed_++;
+        lock.unlock();
+        DatasetImage decoded;
+        decoded.index = index;
+        decoded.path = paths_[index];
+        decoded.image = decode_image(decoded.path);
+        lock.lock();
+        ready_[index] = decoded;
+        decoded_.notify_all();
+    }
+}
+
+cv::Mat DatasetLoader::decode_image(const std::string& path) const
+{
+    CVBASIC_SCOPED_TIMER("decode_image");
+    cv::Mat image;
+    try
+    {
+        int reduced_flags = get_reduced_flags(flags_, reduction_);
+        if (reduction_ == 1 || reduced_flags != -2)
+        {
+            image = cv::imread(path, reduction_ == 1 ? flags_ : reduced_flags);
+        }
+        else
+        {
+            // The other reductions are decoded at the full size and downscaled
+            image = cv::imread(path, flags_);
+            if (!image.empty())
+            {
+                cv::Size size(std::max(image.cols / reduction_, 1), std::max(image.rows / reduction_, 1));
+                cv::resize(image, image, size, 0, 0, cv::INTER_AREA);
+            }
+        }
+    }
+    catch (...)
+    {
+        // A corrupted or oversized file is reported like a file that is not an image, an exception must not leave
+        // the worker thread
+        image.release();
+    }
+    CVBASIC_COUNT(PIXELS_PROCESSED, image.total());
+    return image;
+}
+
+bool DatasetLoader::next(DatasetImage& image)
+{
+    CVBASIC_SCOPED_TIMER("wait_for_image");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (next_returned_ < paths_.size())
+    {
+        decoded_.wait(lock, [this] { return ready_.count(next_returned_) > 0; });
+        std::map<size_t, DatasetImage>::iterator it = ready_.find(next_returned_);
+        image = it->second;
+        ready_.erase(it);
+        ++next_returned_;
+        returned_.notify_all();
+        if (!image.image.empty())
+        {
+            return true;
+        }
+        failures_.push_back(image.path);
+    }
+    return false;
+}
+
+std::vector<std::string> DatasetLoader::failures()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return failures_;
+}
+
+bool list_directory(const std::string& directory, std::vector<std::string>& paths)
+{
+    paths.clear();
+    DIR* directory_stream = opendir(directory.c_str());
+    if (directory_stream == nullptr)
+    {
+        return false;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(directory_stream)) != nullptr)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+        paths.push_back(directory + entry->d_name);
+    }
+    closedir(directory_stream);
+
+    // The order of readdir is unspecified, sort it so every run sees the images in the same order
+    std::sort(paths.begin(), paths.end());
+    return true;
+}
@@ -0,0 +1,294 @@
+/**
+ * @file grabcut.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The coarse-to-fine GrabCut segmentation.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "image_segmentation/grabcut.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "instrumentation/instrumentation.hpp"
+
+// Solving a tile with frozen models needs cv::GC_EVAL_FREEZE_MODEL, older versions refine the whole image instead
+#if CV_VERSION_MAJOR >= 4
+#define HAVE_GC_EVAL_FREEZE_MODEL
+#endif
+
+/**
+ * @brief The number of values of a color model, 5 components with a weight, 3 means and 9 covariances each.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const int MODEL_SIZE = 65;
+
+/**
+ * @brief Check whether a matrix holds a color model in the layout of cv::grabCut.
+ * 
+ * @param[in] model The matrix.
+ * @return True if the matrix is a color model, false otherwise.
+ * @since 0.0.2
+ */
+static inline bool is_model(const cv::Mat& model)
+{
+    return model.type() == CV_64FC1 && model.total() == (size_t)MODEL_SIZE;
+}
+
+GrabCutModel::GrabCutModel()
+    : learning_time_(0),
+      saved_time_(0)
+{
+}
+
+GrabCutModel::~GrabCutModel()
+{
+}
+
+bool GrabCutModel::empty() const
+{
+    return !is_model(background_model_) || !is_model(foreground_model_);
+}
+
+void GrabCutModel::clear()
+{
+    background_model_.release();
+    foreground_model_.release();
+    learning_time_ = 0;
+}
+
+void GrabCutModel::learn(const cv::Mat& image, const cv::Mat& mask)
+{
+    CVBASIC_SCOPED_TIMER("grabcut_learn");
+    // No iteration, cv::grabCut only initializes the models from the mask
+    int64 start = cv::getTickCount();
+    cv::grabCut(image, mask, cv::Rect(), background_model_, foreground_model_, 0, cv::GC_INIT_WITH_MASK);
+    learning_time_ = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+}
+
+void GrabCutModel::segment(const cv::Mat& image, cv::Mat& mask, const int& iterations)
+{
+    CVBASIC_SCOPED_TIMER("grabcut_segment");
+    CVBASIC_COUNT(PIXELS_PROCESSED, image.total());
+    if (empty())
+    {
+        learn(image, mask);
+    }
+    else
+    {
+        saved_time_ += learning_time_;
+    }
+    cv::grabCut(image, mask, cv::Rect(), background_model_, foreground_model_, std::max(iterations, 1), cv::GC_EVAL);
+}
+
+const cv::Mat& GrabCutModel::background_model() const
+{
+    return background_model_;
+}
+
+const cv::Mat& GrabCutModel::foreground_model() const
+{
+    return foreground_model_;
+}
+
+double GrabCutModel::learning_time() const
+{
+    return learning_time_;
+}
+
+double GrabCutModel::saved_time() const
+{
+    return saved_time_;
+}
+
+bool GrabCutModel::save(const std::string& path) const
+{
+    if (empty())
+    {
+        return false;
+    }
+    cv::FileStorage storage(path, cv::FileStorage::WRITE);
+    if (!storage.isOpened())
+    {
+        return false;
+    }
+    storage << "background_model" << background_model_;
+    storage << "foreground_model" << foreground_model_;
+    storage << "learning_time" << learning_time_;
+    return true;
+}
+
+bool GrabCutModel::load(const std::string& path)
+{
+    cv::FileStorage storage(path, cv::FileStorage::READ);
+    if (!storage.isOpened())
+    {
+        return false;
+    }
+    cv::Mat background_model, foreground_model;
+    double learning_time = 0;
+    storage["background_model"] >> background_model;
+    storage["foreground_model"] >> foreground_model;
+    storage["learning_time"] >> learning_time;
+    if (!is_model(background_model) || !is_model(foreground_model))
+    {
+        return false;
+    }
+    background_model_ = background_model.reshape(1, 1);
+    foreground_model_ = foreground_model.reshape(1, 1);
+    learning_time_ = learning_time;
+    return true;
+}
+
+MultiResolutionGrabCut::MultiResolutionGrabCut(const double& scale,
+                                               const int& band_width,
+                                               const int& iterations,
+                                               const int& tile_size)
+    : scale_(std::max(scale, 1.0)),
+      band_width_(std::max(band_width, 1)),
+      iterations_(std::max(iterations, 1)),
+      tile_size_(std::max(tile_size, 1))
+{
+}
+
+MultiResolutionGrabCut::~MultiResolutionGrabCut()
+{
+}
+
+void MultiResolutionGrabCut::segment(const cv::Mat& image, cv::Mat& mask, GrabCutModel& model) const
+{
+    CVBASIC_SCOPED_TIMER("grabcut_multi_resolution");
+    CV_Assert(image.type() == CV_8UC3 && mask.type() == CV_8UC1 && image.size() == mask.size());
+    if (scale_ <= 1)
+    {
+        model.segment(image, mask, iterations_);
+        return;
+    }
+
+    // Learn or reuse the color models and solve the graph cut on the downscaled image
+    cv::Size coarse_size(std::max(cvRound(image.cols / scale_), 1), std::max(cvRound(image.rows / scale_), 1));
+    cv::Mat coarse_image, coarse_mask;
+    cv::resize(image, coarse_image, coarse_size, 0, 0, cv::INTER_AREA);
+    cv::resize(mask, coarse_mask, coarse_size, 0, 0, cv::INTER_NEAREST);
+    model.segment(coarse_image, coarse_mask, iterations_);
+
+    // Find the band around the upsampled boundary
+    cv::Mat upsampled_mask, coarse_foreground, dilated_foreground, eroded_foreground, band;
+    cv::resize(coarse_mask, upsampled_mask, image.size(), 0, 0, cv::INTER_NEAREST);
+    cv::bitwise_and(upsampled_mask, cv::Scalar(1), coarse_foreground);
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * band_width_ + 1, 2 * band_width_ + 1));
+    cv::dilate(coarse_foreground, dilated_foreground, kernel);
+    cv::erode(coarse_foreground, eroded_foreground, kernel);
+    cv::compare(dilated_foreground, eroded_foreground, band, cv::CMP_NE);
+
+    // Fix the pixels outside the band, the pixels inside it stay probable, and the user constraints are kept
+    cv::Mat fixed_mask(image.size(), CV_8UC1);
+    for (int row_index = 0; row_index < image.rows; ++row_index)
+    {
+        const uchar* mask_row = mask.ptr<uchar>(row_index);
+        const uchar* foreground_row = coarse_foreground.ptr<uchar>(row_index);
+        const uchar* band_row = band.ptr<uchar>(row_index);
+        uchar* fixed_row = fixed_mask.ptr<uchar>(row_index);
+        for (int column_index = 0; column_index < image.cols; ++column_index)
+        {
+            if (mask_row[column_index] == cv::GC_BGD || mask_row[column_index] == cv::GC_FGD)
+            {
+                fixed_row[column_index] = mask_row[column_index];
+            }
+            else if (band_row[column_index])
+            {
+                fixed_row[column_index] = foreground_row[column_index] ? cv::GC_PR_FGD : cv::GC_PR_BGD;
+            }
+            else
+            {
+                fixed_row[column_index] = foreground_row[column_index] ? cv::GC_FGD : cv::GC_BGD;
+            }
+        }
+    }
+
+    // Solve the band again at full resolution with the learned models
+    cv::Mat refined_mask = fixed_mask.clone();
+#ifdef HAVE_GC_EVAL_FREEZE_MODEL
+    cv::Rect image_rect(0, 0, image.cols, image.rows);
+    std::vector<cv::Rect> tiles;
+    for (int y = 0; y < image.rows; y += tile_size_)
+    {
+        for (int x = 0; x < image.cols; x += tile_size_)
+        {
+            cv::Rect tile = cv::Rect(x, y, tile_size_, tile_size_) & image_rect;
+            if (cv::countNonZero(band(tile)) > 0)
+            {
+                tiles.push_back(tile);
+            }
+        }
+    }
+    cv::parallel_for_(cv::Range(0, (int)tiles.size()), [&](const cv::Range& range) {
+        for (int tile_index = range.start; tile_index < range.end; ++tile_index)
+        {
+            // Solve an enlarged tile so that the pixels at the tile border keep their neighbours
+            CVBASIC_SCOPED_TIMER("grabcut_tile");
+            const cv::Rect& tile = tiles[tile_index];
+            cv::Rect context = cv::Rect(tile.x - band_width_, tile.y - band_width_,
+                                        tile.width + 2 * band_width_, tile.height + 2 * band_width_) &
+                               image_rect;
+            CVBASIC_COUNT(PIXELS_PROCESSED, (uint64_t)context.area());
+            cv::Mat context_mask = fixed_mask(context).clone();
+            cv::Mat tile_background_model = model.background_model().clone();
+            cv::Mat tile_foreground_model = model.foreground_model().clone();
+            cv::grabCut(image(context), context_mask, cv::Rect(), tile_background_model, tile_foreground_model,
+                        1, cv::GC_EVAL_FREEZE_MODEL);
+            context_mask(cv::Rect(tile.x - context.x, tile.y - context.y, tile.width, tile.height)).copyTo(refined_mask(tile));
+        }
+    });
+#else
+    cv::Mat background_model = model.background_model().clone();
+    cv::Mat foreground_model = model.foreground_model().clone();
+    CVBASIC_COUNT(PIXELS_PROCESSED, image.total());
+    cv::grabCut(image, refined_mask, cv::Rect(), background_model, foreground_model, 1, cv::GC_EVAL);
+#endif
+
+    // Only the user constraints stay definite in the output, like in the output of cv::grabCut
+    for (int row_index = 0; row_index < image.rows; ++row_index)
+    {
+        uchar* mask_row = mask.ptr<uchar>(row_index);
+        const uchar* refined_row = refined_mask.ptr<uchar>(row_index);
+        for (int column_index = 0; column_index < image.cols; ++column_index)
+        {
+            if (mask_row[column_index] != cv::GC_BGD && mask_row[column_index] != cv::GC_FGD)
+            {
+                mask_row[column_index] = (refined_row[column_index] & 1) ? cv::GC_PR_FGD : cv::GC_PR_BGD;
+            }
+        }
+    }
+}
+
+double get_boundary_iou(const cv::Mat& mask_0, const cv::Mat& mask_1, const int& distance)
+{
+    CV_Assert(mask_0.type() == CV_8UC1 && mask_1.type() == CV_8UC1 && mask_0.size() == mask_1.size());
+    cv::Mat kernel = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(2 * distance + 1, 2 * distance + 1));
+    cv::Mat boundaries[2];
+    const cv::Mat* masks[2] = {&mask_0, &mask_1};
+    for (int i = 0; i < 2; ++i)
+    {
+        cv::Mat foreground, eroded_foreground;
+        cv::compare(*masks[i], 0, foreground, cv::CMP_NE);
+        cv::erode(foreground, eroded_foreground, kernel);
+        cv::bitwise_xor(foreground, eroded_foreground, boundaries[i]);
+    }
+    cv::Mat intersection, union_;
+    cv::bitwise_and(boundaries[0], boundaries[1], intersection);
+    cv::bitwise_or(boundaries[0], boundaries[1], union_);
+    int union_area = cv::countNonZero(union_);
+    if (union_area == 0)
+    {
+        return 1;
+    }
+    return (double)cv::countNonZero(intersection) / union_area;
+}
@@ -1,48 +1,95 @@
-#include <dirent.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <sstream>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include "buffer_pool/buffer_pool.hpp"
+#include "image_segmentation/dataset_loader.hpp"
+#include "image_segmentation/grabcut.hpp"
+#include "image_segmentation/segmentation_output.hpp"
+#include "instrumentation/instrumentation.hpp"
+
 std::vector<std::vector<cv::Point>> foreGround;
+std::vector<std::vector<cv::Point>> backGround;
 void CallBackFunc(int event, int x, int y, int flags, void* userdata);
+void drawStrokes(cv::Mat& mask, const std::vector<std::vector<cv::Point>>& strokes, uchar value);
+void showForeground(const cv::Mat& image, const cv::Mat& mask);
+double getElapsedTime(int64 start);
 
-int main()
+int main(int argc, char** argv)
 {
-    std::string dirName = "sample_images/";
-    DIR* pDir;
-    pDir = opendir(dirName.c_str());
-    if (pDir == NULL)
+    start_instrumentation();
+    install_buffer_pool();
+
+    double scale = 1;
+    bool hasScale = false;
+    bool reuseModel = false;
+    std::string loadPath, savePath;
+    for (int i = 1; i < argc; i++)
     {
-        std::cout << "Directory not found." << std::endl;
+        std::string argument = argv[i];
+        if (argument == "--reuse")
+        {
+            reuseModel = true;
+        }
+        else if (argument == "--load-model" && i + 1 < argc)
+        {
+            loadPath = argv[++i];
+        }
+        else if (argument == "--save-model" && i + 1 < argc)
+        {
+            savePath = argv[++i];
+        }
+        else if (!hasScale && argument[0] != '-')
+        {
+            scale = std::stod(argument);
+            hasScale = true;
+        }
+        else
+        {
+            std::cout << "To run the grabcut segmentation, type ./grabcut_segmentation [<scale>] [--reuse] "
+                      << "[--load-model <path>] [--save-model <path>]" << std::endl;
+            return 1;
+        }
+    }
+    if (scale < 1)
+    {
+        std::cout << "Scale has to be at least 1" << std::endl;
         return 1;
     }
+    MultiResolutionGrabCut multiResolutionGrabCut(scale);
 
-    struct dirent* pDirent;
-    std::vector<std::string> img_paths;
-    while ((pDirent = readdir(pDir)) != NULL)
+    // Loaded models seed every image, so they are reused like the models of the previous image
+    GrabCutModel model;
+    if (!loadPath.empty())
     {
-        if (strcmp(pDirent->d_name, ".") == 0 || strcmp(pDirent->d_name, "..") == 0)
+        if (!model.load(loadPath))
         {
-            continue;
+            std::cout << "Cannot load the models from " << loadPath << std::endl;
+            return 1;
         }
-        std::string imgPath = dirName;
-        imgPath.append(pDirent->d_name);
-        img_paths.push_back(imgPath);
+        reuseModel = true;
     }
-    closedir(pDir);
 
+    std::vector<std::string> img_paths;
+    if (!list_directory("sample_images/", img_paths))
+    {
+        std::cout << "Directory not found." << std::endl;
+        return 1;
+    }
+
+    // The next images are decoded while the current one is segmented
     cv::Mat image, appliedImg;
-    std::sort(img_paths.begin(), img_paths.end());
-    for (size_t idx = 0; idx < img_paths.size(); idx++)
+    DatasetLoader loader(img_paths);
+    DatasetImage sample;
+    while (loader.next(sample))
     {
-        std::cout << img_paths[idx] << std::endl;
-        image = cv::imread(img_paths[idx], 1);
-        if (image.empty())
-        {
-            break;
-        }
+        std::cout << sample.path << std::endl;
+        image = sample.image;
 
         appliedImg = image.clone();
         foreGround.erase(foreGround.begin(), foreGround.end());
@@ -63,19 +110,92 @@ int main()
             }
         }
 
-        // GrabCut segmentation
-        cv::grabCut(image, result, cv::Rect(), cv::Mat(), cv::Mat(), 1, cv::GC_INIT_WITH_MASK);
+        // GrabCut segmentation, the models of the previous image seed this one if they are reused
+        if (!reuseModel)
+        {
+            model.clear();
+        }
+        bool reused = !model.empty();
+        int64 start = cv::getTickCount();
+        if (scale > 1)
+        {
+            // Run the full resolution segmentation as the reference of the coarse-to-fine one
+            cv::Mat reference = result.clone();
+            cv::Mat backgroundModel, foregroundModel;
+            cv::grabCut(image, reference, cv::Rect(), backgroundModel, foregroundModel, 1, cv::GC_INIT_WITH_MASK);
+            double referenceTime = getElapsedTime(start);
+
+            start = cv::getTickCount();
+            multiResolutionGrabCut.segment(image, result, model);
+            double coarseToFineTime = getElapsedTime(start);
+
+            // The boundary width is 2% of the image diagonal
+            int boundaryWidth = std::max(cvRound(0.02 * std::sqrt((double)image.rows * image.rows + image.cols * image.cols)), 1);
+            double boundaryIou = get_boundary_iou(reference & 1, result & 1, boundaryWidth);
+            std::cout << "Full resolution: " << referenceTime << " ms, coarse-to-fine: " << coarseToFineTime
+                      << " ms (" << referenceTime / coarseToFineTime << "x), boundary IoU: " << boundaryIou << std::endl;
+        }
+        else
+        {
+            multiResolutionGrabCut.segment(image, result, model);
+            std::cout << "Segmentation: " << getElapsedTime(start) << " ms" << std::endl;
+        }
+        if (reused)
+        {
+            std::cout << "Models reused, learning time saved: " << model.learning_time() << " ms, total saved: "
+                      << model.saved_time() << " ms" << std::endl;
+        }
+        else
+        {
+            std::cout << "Models learned in " << model.learning_time() << " ms" << std::endl;
+        }
+        showForeground(image, result);
+
+        // Refine the segmentation with more strokes, the models carry over so they are not learned again
+        std::cout << "Draw more strokes, left for foreground and right for background, then press r to refine, "
+                  << "or press another key for the next image" << std::endl;
+        foreGround.clear();
+        backGround.clear();
+        while ((cv::waitKey() & 0xFF) == 'r')
+        {
+            drawStrokes(result, foreGround, cv::GC_FGD);
+            drawStrokes(result, backGround, cv::GC_BGD);
+            foreGround.clear();
+            backGround.clear();
+            start = cv::getTickCount();
+            multiResolutionGrabCut.segment(image, result, model);
+            std::cout << "Refinement: " << getElapsedTime(start) << " ms, learning time saved: "
+                      << model.learning_time() << " ms, total saved: " << model.saved_time() << " ms" << std::endl;
+            showForeground(image, result);
+        }
 
-        // Get the pixels marked as likely foreground
-        cv::compare(result, cv::GC_PR_FGD, result, cv::CMP_EQ);
+        // Report the size of the compact mask
+        RunLengthMask encodedMask;
+        encode_run_length(result, 1, encodedMask);
+        std::ostringstream encodedStream;
+        size_t encodedSize = write_run_length(encodedMask, encodedStream);
+        std::cout << "Mask: " << encodedMask.runs.size() << " runs, " << encodedSize << " bytes" << std::endl;
+    }
+    for (const std::string& failure : loader.failures())
+    {
+        std::cout << failure << ": cannot be read, skipped" << std::endl;
+    }
 
-        // Generate output image
-        cv::Mat foreground(image.size(), CV_8UC3, cv::Scalar(0, 0, 0));
-        image.copyTo(foreground, result);
-        cv::imshow("Segmented Image", foreground);
+    if (!savePath.empty())
+    {
+        if (model.save(savePath))
+        {
+            std::cout << "Models saved to " << savePath << std::endl;
+        }
+        else
+        {
+            std::cout << "Cannot save the models to " << savePath << std::endl;
+        }
     }
     cv::waitKey();
 
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("grabcut_segmentation");
     return 0;
 }
 
@@ -92,4 +212,38 @@ void CallBackFunc(int event, int x, int y, int flags, void* userdata)
     {
         foreGround[foreGround.size() - 1].push_back(cv::Point(x, y));
     }
+    else if (event == cv::EVENT_RBUTTONDOWN)
+    {
+        std::vector<cv::Point> temp;
+        temp.push_back(cv::Point(x, y));
+        backGround.push_back(temp);
+    }
+    else if (event == cv::EVENT_MOUSEMOVE && flags == cv::EVENT_FLAG_RBUTTON && backGround.size() > 0)
+    {
+        backGround[backGround.size() - 1].push_back(cv::Point(x, y));
+    }
+}
+
+void drawStrokes(cv::Mat& mask, const std::vector<std::vector<cv::Point>>& strokes, uchar value)
+{
+    for (unsigned int i = 0; i < strokes.size(); i++)
+    {
+        for (unsigned int j = 0; j < strokes[i].size(); j++)
+        {
+            cv::line(mask, strokes[i][j], strokes[i][std::min(j + 1, (unsigned int)strokes[i].size() - 1)], value, 5);
+        }
+    }
+}
+
+void showForeground(const cv::Mat& image, const cv::Mat& mask)
+{
+    // Cut out the pixels marked as foreground, definite or likely, in a single pass
+    cv::Mat foreground;
+    cut_out(image, mask, 1, foreground);
+    cv::imshow("Segmented Image", foreground);
+}
+
+double getElapsedTime(int64 start)
+{
+    return (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
 }
@@ -0,0 +1,212 @@
+/**
+ * @file incremental_watershed.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The watershed segmentation that is updated incrementally when scribbles are added.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "image_segmentation/incremental_watershed.hpp"
+
+#include <algorithm>
+
+#include "instrumentation/instrumentation.hpp"
+
+/**
+ * @brief Extend a bounding box to contain a pixel.
+ * 
+ * @param[in,out] box The bounding box, empty if it contains no pixel yet.
+ * @param[in] x The column of the pixel.
+ * @param[in] y The row of the pixel.
+ * @since 0.0.2
+ */
+static inline void extend_bounding_box(cv::Rect& box, const int& x, const int& y)
+{
+    if (box.empty())
+    {
+        box = cv::Rect(x, y, 1, 1);
+        return;
+    }
+    int left = std::min(box.x, x);
+    int top = std::min(box.y, y);
+    int right = std::max(box.x + box.width, x + 1);
+    int bottom = std::max(box.y + box.height, y + 1);
+    box = cv::Rect(left, top, right - left, bottom - top);
+}
+
+IncrementalWatershed::IncrementalWatershed(const int& number_of_tiles)
+    : watershed_(number_of_tiles),
+      number_of_labels_(0)
+{
+}
+
+IncrementalWatershed::~IncrementalWatershed()
+{
+}
+
+void IncrementalWatershed::reset(const cv::Mat& image, const cv::Mat& seeds)
+{
+    CVBASIC_SCOPED_TIMER("incremental_watershed_reset");
+    CV_Assert(image.type() == CV_8UC3 && seeds.type() == CV_32SC1 && image.size() == seeds.size());
+    image_ = image.isContinuous() ? image : image.clone();
+    seeds_ = seeds.clone();
+    labels_ = seeds.clone();
+    watershed_.segment(image_, labels_);
+
+    double max_seed;
+    cv::minMaxLoc(seeds_, nullptr, &max_seed);
+    number_of_labels_ = std::max((int)max_seed, 0);
+    bounding_boxes_.assign(number_of_labels_ + 1, cv::Rect());
+    for (int row_index = 0; row_index < labels_.rows; ++row_index)
+    {
+        const int* label_row = labels_.ptr<int>(row_index);
+        for (int column_index = 0; column_index < labels_.cols; ++column_index)
+        {
+            if (label_row[column_index] > 0)
+            {
+                extend_bounding_box(bounding_boxes_[label_row[column_index]], column_index, row_index);
+            }
+        }
+    }
+}
+
+int IncrementalWatershed::add_scribble(const std::vector<cv::Point>& scribble, std::vector<int>& changed_pixels)
+{
+    CVBASIC_SCOPED_TIMER("incremental_watershed_add_scribble");
+    changed_pixels.clear();
+    int rows = labels_.rows;
+    int cols = labels_.cols;
+    cv::Rect interior(1, 1, cols - 2, rows - 2);
+    int label = number_of_labels_ + 1;
+
+    // The seeds touched by the scribble are absorbed, the basins it is drawn on are flooded again
+    std::vector<uchar> merged(label + 1, 0);
+    std::vector<uchar> affected(label + 1, 0);
+    cv::Rect region;
+    for (size_t i = 0; i < scribble.size(); ++i)
+    {
+        const cv::Point& pixel = scribble[i];
+        if (!interior.contains(pixel))
+        {
+            continue;
+        }
+        extend_bounding_box(region, pixel.x, pixel.y);
+        int basin = labels_.at<int>(pixel.y, pixel.x);
+        if (basin > 0)
+        {
+            affected[basin] = 1;
+        }
+        for (int row_index = pixel.y - 1; row_index <= pixel.y + 1; ++row_index)
+        {
+            for (int column_index = pixel.x - 1; column_index <= pixel.x + 1; ++column_index)
+            {
+                int seed = seeds_.at<int>(row_index, column_index);
+                if (seed > 0)
+                {
+                    merged[seed] = 1;
+                    affected[seed] = 1;
+                }
+            }
+        }
+    }
+    if (region.empty())
+    {
+        return 0;
+    }
+    number_of_labels_ = label;
+    bounding_boxes_.push_back(cv::Rect());
+    for (int i = 1; i < label; ++i)
+    {
+        if (affected[i] && !bounding_boxes_[i].empty())
+        {
+            region |= bounding_boxes_[i];
+        }
+    }
+
+    // Grow the region by one pixel so that the labels around the cleared basins seed the flood
+    region = cv::Rect(region.x - 1, region.y - 1, region.width + 2, region.height + 2) & cv::Rect(0, 0, cols, rows);
+    cv::Mat previous_labels = labels_(region).clone();
+    cv::Rect cleared = region & interior;
+
+    // Clear the affected basins and the watershed lines around them, then restore the seeds inside them
+    for (int row_index = cleared.y; row_index < cleared.y + cleared.height; ++row_index)
+    {
+        int* label_row = labels_.ptr<int>(row_index);
+        int* seed_row = seeds_.ptr<int>(row_index);
+        for (int column_index = cleared.x; column_index < cleared.x + cleared.width; ++column_index)
+        {
+            int previous = previous_labels.at<int>(row_index - region.y, column_index - region.x);
+            bool clear = previous > 0 && affected[previous];
+            if (previous == Watershed::WATERSHED_LINE)
+            {
+                const int neighbour_offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+                for (int i = 0; i < 4 && !clear; ++i)
+                {
+                    cv::Point neighbour(column_index + neighbour_offsets[i][0] - region.x,
+                                        row_index + neighbour_offsets[i][1] - region.y);
+                    if (neighbour.x >= 0 && neighbour.x < region.width && neighbour.y >= 0 && neighbour.y < region.height)
+                    {
+                        int neighbour_label = previous_labels.at<int>(neighbour.y, neighbour.x);
+                        clear = neighbour_label > 0 && affected[neighbour_label];
+                    }
+                }
+            }
+            if (seed_row[column_index] > 0 && merged[seed_row[column_index]])
+            {
+                seed_row[column_index] = label;
+            }
+            if (clear)
+            {
+                label_row[column_index] = std::max(seed_row[column_index], 0);
+            }
+        }
+    }
+    for (size_t i = 0; i < scribble.size(); ++i)
+    {
+        if (interior.contains(scribble[i]))
+        {
+            seeds_.at<int>(scribble[i].y, scribble[i].x) = label;
+            labels_.at<int>(scribble[i].y, scribble[i].x) = label;
+        }
+    }
+    watershed_.reflood(image_, labels_, region);
+
+    // Rebuild the bounding boxes of the flooded basins and collect the pixels that changed
+    for (int i = 1; i < label; ++i)
+    {
+        if (affected[i])
+        {
+            bounding_boxes_[i] = cv::Rect();
+        }
+    }
+    for (int row_index = region.y; row_index < region.y + region.height; ++row_index)
+    {
+        const int* label_row = labels_.ptr<int>(row_index);
+        const int* previous_row = previous_labels.ptr<int>(row_index - region.y);
+        for (int column_index = region.x; column_index < region.x + region.width; ++column_index)
+        {
+            int current = label_row[column_index];
+            if (current > 0)
+            {
+                extend_bounding_box(bounding_boxes_[current], column_index, row_index);
+            }
+            if (current != previous_row[column_index - region.x])
+            {
+                changed_pixels.push_back(row_index * cols + column_index);
+            }
+        }
+    }
+    return label;
+}
+
+const cv::Mat& IncrementalWatershed::labels() const
+{
+    return labels_;
+}
+
+int IncrementalWatershed::number_of_labels() const
+{
+    return number_of_labels_;
+}
@@ -0,0 +1,412 @@
+/**
+ * @file segmentation_output.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The output stage of the segmentation tools: color overlays, alpha blends, cutouts and run-length masks.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "image_segmentation/segmentation_output.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "instrumentation/instrumentation.hpp"
+
+// Every OpenCV 4 release has the wrapping arithmetic of the universal intrinsics
+#if CV_VERSION_MAJOR >= 4
+#include <opencv2/core/hal/intrin.hpp>
+#define HAVE_UNIVERSAL_INTRINSICS
+#endif
+
+/**
+ * @brief The magic bytes at the beginning of a serialized run-length mask.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const char RUN_LENGTH_MAGIC[4] = {'R', 'L', 'M', '1'};
+
+/**
+ * @brief Get the lookup table entry of a label.
+ * 
+ * @param[in] label The label.
+ * @param[in] number_of_colors The size of the lookup table.
+ * @return The entry of the label, 0 for negative labels and labels out of the table.
+ * @since 0.0.2
+ */
+template <typename Label>
+static inline unsigned get_color_index(const Label& label, const unsigned& number_of_colors)
+{
+    // Negative labels wrap around to large values, so a single comparison handles both cases
+    unsigned index = (unsigned)label;
+    return index < number_of_colors ? index : 0;
+}
+
+/**
+ * @brief Color the rows of a label image in parallel.
+ * 
+ * The colors are gathered from the lookup table straight into the output, the gather is the whole work.
+ * 
+ * @param[in] labels The single-channel labels.
+ * @param[in] colors The lookup table.
+ * @param[out] output The allocated 8-bit 3-channel color image.
+ * @since 0.0.2
+ */
+template <typename Label>
+static void color_rows(const cv::Mat& labels, const std::vector<cv::Vec3b>& colors, cv::Mat& output)
+{
+    const uchar* table = colors[0].val;
+    unsigned number_of_colors = colors.size();
+    cv::parallel_for_(cv::Range(0, labels.rows), [&](const cv::Range& range) {
+        for (int row_index = range.start; row_index < range.end; ++row_index)
+        {
+            const Label* label_row = labels.ptr<Label>(row_index);
+            uchar* output_row = output.ptr<uchar>(row_index);
+            for (int column_index = 0; column_index < labels.cols; ++column_index)
+            {
+                const uchar* color = table + 3 * get_color_index(label_row[column_index], number_of_colors);
+                output_row[3 * column_index] = color[0];
+                output_row[3 * column_index + 1] = color[1];
+                output_row[3 * column_index + 2] = color[2];
+            }
+        }
+    });
+}
+
+/**
+ * @brief Blend a row of colors over a row of an image.
+ * 
+ * The two weights add up to 256, so the weighted sum of two bytes fits 16 bits and the blend is exact in the 16-bit
+ * lanes of the universal intrinsics.
+ * 
+ * @param[in] image_row The bytes of the image row.
+ * @param[in] color_row The bytes of the colors.
+ * @param[in] weight The fixed-point opacity of the colors in the range [0, 256].
+ * @param[in] length The number of bytes of the rows.
+ * @param[out] output_row The bytes of the blended row.
+ * @since 0.0.2
+ */
+static void blend_row(const uchar* image_row, const uchar* color_row, const int& weight, const int& length,
+                      uchar* output_row)
+{
+    int i = 0;
+#if defined(HAVE_UNIVERSAL_INTRINSICS) && CV_SIMD128
+    cv::v_uint16x8 image_weight = cv::v_setall_u16((ushort)(256 - weight));
+    cv::v_uint16x8 color_weight = cv::v_setall_u16((ushort)weight);
+    for (; i <= length - 16; i += 16)
+    {
+        cv::v_uint16x8 image_low, image_high, color_low, color_high;
+        cv::v_expand(cv::v_load(image_row + i), image_low, image_high);
+        cv::v_expand(cv::v_load(color_row + i), color_low, color_high);
+        cv::v_uint16x8 low = cv::v_add_wrap(cv::v_mul_wrap(image_low, image_weight),
+                                            cv::v_mul_wrap(color_low, color_weight));
+        cv::v_uint16x8 high = cv::v_add_wrap(cv::v_mul_wrap(image_high, image_weight),
+                                             cv::v_mul_wrap(color_high, color_weight));
+        cv::v_store(output_row + i, cv::v_pack(cv::v_shr<8>(low), cv::v_shr<8>(high)));
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        output_row[i] = (uchar)((image_row[i] * (256 - weight) + color_row[i] * weight) >> 8);
+    }
+}
+
+/**
+ * @brief Blend the label colors over the rows of an image in parallel.
+ * 
+ * The colors of a row are gathered into a buffer, then the whole row is blended at once. A pixel without a color
+ * takes its own image color, which the blend leaves unchanged.
+ * 
+ * @param[in] image The 8-bit 3-channel image.
+ * @param[in] labels The single-channel labels.
+ * @param[in] colors The lookup table.
+ * @param[in] weight The fixed-point opacity of the label colors in the range [0, 256].
+ * @param[out] output The allocated 8-bit 3-channel blended image.
+ * @since 0.0.2
+ */
+template <typename Label>
+static void blend_rows(const cv::Mat& image, const cv::Mat& labels, const std::vector<cv::Vec3b>& colors,
+                       const int& weight, cv::Mat& output)
+{
+    const uchar* table = colors[0].val;
+    unsigned number_of_colors = colors.size();
+    cv::parallel_for_(cv::Range(0, labels.rows), [&](const cv::Range& range) {
+        // The buffer keeps its capacity between the calls on a thread
+        static thread_local std::vector<uchar> color_row;
+        color_row.resize(3 * labels.cols);
+        for (int row_index = range.start; row_index < range.end; ++row_index)
+        {
+            const uchar* image_row = image.ptr<uchar>(row_index);
+            const Label* label_row = labels.ptr<Label>(row_index);
+            for (int column_index = 0; column_index < labels.cols; ++column_index)
+            {
+                unsigned index = get_color_index(label_row[column_index], number_of_colors);
+                const uchar* color = index != 0 ? table + 3 * index : image_row + 3 * column_index;
+                color_row[3 * column_index] = color[0];
+                color_row[3 * column_index + 1] = color[1];
+                color_row[3 * column_index + 2] = color[2];
+            }
+            blend_row(image_row, color_row.data(), weight, 3 * labels.cols, output.ptr<uchar>(row_index));
+        }
+    });
+}
+
+/**
+ * @brief Write an unsigned integer as a variable-length integer with 7 bits per byte.
+ * 
+ * @param[in] value The value.
+ * @param[out] stream The output stream.
+ * @return The number of bytes written.
+ * @since 0.0.2
+ */
+static size_t write_varint(unsigned value, std::ostream& stream)
+{
+    size_t size = 1;
+    while (value >= 0x80)
+    {
+        stream.put((char)((value & 0x7F) | 0x80));
+        value >>= 7;
+        ++size;
+    }
+    stream.put((char)value);
+    return size;
+}
+
+/**
+ * @brief Read a variable-length integer written by write_varint.
+ * 
+ * @param[in] stream The input stream.
+ * @param[out] value The value.
+ * @return False if the stream ends or the value does not fit 32 bits, true otherwise.
+ * @since 0.0.2
+ */
+static bool read_varint(std::istream& stream, unsigned& value)
+{
+    value = 0;
+    for (int shift = 0; shift < 32; shift += 7)
+    {
+        int byte = stream.get();
+        if (!stream || (shift == 28 && (byte & 0x70) != 0))
+        {
+            return false;
+        }
+        value |= (unsigned)(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<cv::Vec3b> make_label_colors(const int& number_of_labels, cv::RNG& rng)
+{
+    std::vector<cv::Vec3b> colors;
+    colors.reserve(std::max(number_of_labels, 0) + 1);
+    colors.push_back(cv::Vec3b(0, 0, 0));
+    for (int i = 0; i < number_of_labels; ++i)
+    {
+        int b = rng.uniform(0, 255);
+        int g = rng.uniform(0, 255);
+        int r = rng.uniform(0, 255);
+        colors.push_back(cv::Vec3b((uchar)b, (uchar)g, (uchar)r));
+    }
+    return colors;
+}
+
+void color_labels(const cv::Mat& labels, const std::vector<cv::Vec3b>& colors, cv::Mat& output)
+{
+    CVBASIC_SCOPED_TIMER("color_labels");
+    CVBASIC_COUNT(PIXELS_PROCESSED, labels.total());
+    CV_Assert((labels.type() == CV_8UC1 || labels.type() == CV_32SC1) && !colors.empty());
+    output.create(labels.size(), CV_8UC3);
+    if (labels.type() == CV_8UC1)
+    {
+        color_rows<uchar>(labels, colors, output);
+    }
+    else
+    {
+        color_rows<int>(labels, colors, output);
+    }
+}
+
+void color_labels(const cv::Mat& labels, const std::vector<cv::Vec3b>& colors,
+                  const std::vector<int>& pixels, cv::Mat& output)
+{
+    CVBASIC_SCOPED_TIMER("color_labels_pixels");
+    CVBASIC_COUNT(PIXELS_PROCESSED, (uint64_t)pixels.size());
+    CV_Assert(labels.type() == CV_32SC1 && output.type() == CV_8UC3 && labels.size() == output.size());
+    CV_Assert(labels.isContinuous() && output.isContinuous() && !colors.empty());
+    const int* label_data = labels.ptr<int>();
+    uchar* output_data = output.ptr<uchar>();
+    const uchar* table = colors[0].val;
+    unsigned number_of_colors = colors.size();
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+        const uchar* color = table + 3 * get_color_index(label_data[pixels[i]], number_of_colors);
+        uchar* output_pixel = output_data + 3 * pixels[i];
+        output_pixel[0] = color[0];
+        output_pixel[1] = color[1];
+        output_pixel[2] = color[2];
+    }
+}
+
+void blend_labels(const cv::Mat& image, const cv::Mat& labels, const std::vector<cv::Vec3b>& colors,
+                  const float& alpha, cv::Mat& output)
+{
+    CVBASIC_SCOPED_TIMER("blend_labels");
+    CVBASIC_COUNT(PIXELS_PROCESSED, labels.total());
+    CV_Assert(image.type() == CV_8UC3 && (labels.type() == CV_8UC1 || labels.type() == CV_32SC1));
+    CV_Assert(image.size() == labels.size() && !colors.empty());
+    int weight = cvRound(std::min(std::max(alpha, 0.0f), 1.0f) * 256);
+    output.create(image.size(), CV_8UC3);
+    if (labels.type() == CV_8UC1)
+    {
+        blend_rows<uchar>(image, labels, colors, weight, output);
+    }
+    else
+    {
+        blend_rows<int>(image, labels, colors, weight, output);
+    }
+}
+
+void cut_out(const cv::Mat& image, const cv::Mat& mask, const uchar& foreground_bits, cv::Mat& output)
+{
+    CVBASIC_SCOPED_TIMER("cut_out");
+    CVBASIC_COUNT(PIXELS_PROCESSED, image.total());
+    CV_Assert(image.type() == CV_8UC3 && mask.type() == CV_8UC1 && image.size() == mask.size());
+    output.create(image.size(), CV_8UC3);
+    cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range& range) {
+        for (int row_index = range.start; row_index < range.end; ++row_index)
+        {
+            const uchar* image_row = image.ptr<uchar>(row_index);
+            const uchar* mask_row = mask.ptr<uchar>(row_index);
+            uchar* output_row = output.ptr<uchar>(row_index);
+            for (int column_index = 0; column_index < image.cols; ++column_index)
+            {
+                // All bits set for the foreground and cleared for the background, so there is no branch
+                uchar keep = (uchar)(-(int)((mask_row[column_index] & foreground_bits) != 0));
+                output_row[3 * column_index] = image_row[3 * column_index] & keep;
+                output_row[3 * column_index + 1] = image_row[3 * column_index + 1] & keep;
+                output_row[3 * column_index + 2] = image_row[3 * column_index + 2] & keep;
+            }
+        }
+    });
+}
+
+void encode_run_length(const cv::Mat& mask, const uchar& foreground_bits, RunLengthMask& encoded)
+{
+    CVBASIC_SCOPED_TIMER("encode_run_length");
+    CVBASIC_COUNT(PIXELS_PROCESSED, mask.total());
+    CV_Assert(mask.type() == CV_8UC1);
+    encoded.rows = mask.rows;
+    encoded.cols = mask.cols;
+    encoded.runs.clear();
+    bool is_foreground = false;
+    int run = 0;
+    for (int row_index = 0; row_index < mask.rows; ++row_index)
+    {
+        const uchar* mask_row = mask.ptr<uchar>(row_index);
+        for (int column_index = 0; column_index < mask.cols; ++column_index)
+        {
+            if (((mask_row[column_index] & foreground_bits) != 0) != is_foreground)
+            {
+                encoded.runs.push_back(run);
+                is_foreground = !is_foreground;
+                run = 0;
+            }
+            ++run;
+        }
+    }
+    encoded.runs.push_back(run);
+}
+
+void decode_run_length(const RunLengthMask& encoded, cv::Mat& mask)
+{
+    CVBASIC_SCOPED_TIMER("decode_run_length");
+    CVBASIC_COUNT(PIXELS_PROCESSED, (uint64_t)encoded.rows * encoded.cols);
+    mask.create(encoded.rows, encoded.cols, CV_8UC1);
+    size_t position = 0;
+    size_t number_of_pixels = (size_t)encoded.rows * encoded.cols;
+    for (size_t i = 0; i < encoded.runs.size(); ++i)
+    {
+        uchar value = i % 2 == 0 ? 0 : 255;
+        size_t remaining = encoded.runs[i];
+        CV_Assert(encoded.runs[i] >= 0 && position + remaining <= number_of_pixels);
+        while (remaining > 0)
+        {
+            int row_index = position / encoded.cols;
+            int column_index = position % encoded.cols;
+            size_t length = std::min(remaining, (size_t)(encoded.cols - column_index));
+            memset(mask.ptr<uchar>(row_index) + column_index, value, length);
+            position += length;
+            remaining -= length;
+        }
+    }
+    CV_Assert(position == number_of_pixels);
+}
+
+size_t write_run_length(const RunLengthMask& encoded, std::ostream& stream)
+{
+    CVBASIC_SCOPED_TIMER("write_run_length");
+    stream.write(RUN_LENGTH_MAGIC, sizeof(RUN_LENGTH_MAGIC));
+    size_t size = sizeof(RUN_LENGTH_MAGIC);
+    size += write_varint(encoded.rows, stream);
+    size += write_varint(encoded.cols, stream);
+    size += write_varint(encoded.runs.size(), stream);
+    for (size_t i = 0; i < encoded.runs.size(); ++i)
+    {
+        size += write_varint(encoded.runs[i], stream);
+    }
+    return size;
+}
+
+bool read_run_length(std::istream& stream, RunLengthMask& encoded)
+{
+    CVBASIC_SCOPED_TIMER("read_run_length");
+    char magic[sizeof(RUN_LENGTH_MAGIC)];
+    if (!stream.read(magic, sizeof(magic)) || memcmp(magic, RUN_LENGTH_MAGIC, sizeof(magic)) != 0)
+    {
+        return false;
+    }
+    unsigned rows, cols, number_of_runs;
+    if (!read_varint(stream, rows) || !read_varint(stream, cols) || !read_varint(stream, number_of_runs))
+    {
+        return false;
+    }
+
+    // Only the leading background run can be empty, so there is at most one run per pixel plus that one
+    size_t number_of_pixels = (size_t)rows * cols;
+    if (rows > INT_MAX || cols > INT_MAX || number_of_runs > number_of_pixels + 1)
+    {
+        return false;
+    }
+
+    // The runs have to cover every pixel exactly once, the vector only grows with the runs actually read so a
+    // corrupted count cannot make it allocate
+    std::vector<int> runs;
+    runs.reserve(std::min(number_of_runs, 1u << 16));
+    size_t total = 0;
+    for (unsigned i = 0; i < number_of_runs; ++i)
+    {
+        unsigned run;
+        if (!read_varint(stream, run) || run > INT_MAX || run > number_of_pixels - total || (run == 0 && i > 0))
+        {
+            return false;
+        }
+        runs.push_back(run);
+        total += run;
+    }
+    if (total != number_of_pixels)
+    {
+        return false;
+    }
+    encoded.rows = rows;
+    encoded.cols = cols;
+    encoded.runs.swap(runs);
+    return true;
+}
@@ -0,0 +1,262 @@
+/**
+ * @file watershed.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The priority-flood watershed transform for marker based segmentation.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "image_segmentation/watershed.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include "instrumentation/instrumentation.hpp"
+
+/**
+ * @brief The label of the pixels that are waiting in the queue.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const int IN_QUEUE = -2;
+
+/**
+ * @brief Get the flooding priority between two BGR pixels.
+ * 
+ * @param[in] pixel_0 The first pixel.
+ * @param[in] pixel_1 The second pixel.
+ * @return The maximum absolute difference over the three channels.
+ * @since 0.0.2
+ */
+static inline int get_difference(const uchar* pixel_0, const uchar* pixel_1)
+{
+    int blue = std::abs(pixel_0[0] - pixel_1[0]);
+    int green = std::abs(pixel_0[1] - pixel_1[1]);
+    int red = std::abs(pixel_0[2] - pixel_1[2]);
+    return std::max(blue, std::max(green, red));
+}
+
+BucketQueue::BucketQueue(int* links)
+    : links_(links),
+      active_bucket_(NUMBER_OF_BUCKETS - 1)
+{
+    std::fill(heads_, heads_ + NUMBER_OF_BUCKETS, -1);
+    std::fill(tails_, tails_ + NUMBER_OF_BUCKETS, -1);
+}
+
+Watershed::Watershed(const int& number_of_tiles,
+                     const int& seam_band)
+    : number_of_tiles_(std::max(number_of_tiles, 1)),
+      seam_band_(std::max(seam_band, 1))
+{
+}
+
+Watershed::~Watershed()
+{
+}
+
+void Watershed::segment(const cv::Mat& image, cv::Mat& markers)
+{
+    CVBASIC_SCOPED_TIMER("watershed_segment");
+    CVBASIC_COUNT(PIXELS_PROCESSED, markers.total());
+    CV_Assert(image.type() == CV_8UC3 && markers.type() == CV_32SC1);
+    CV_Assert(image.size() == markers.size() && markers.isContinuous());
+    cv::Mat source = image.isContinuous() ? image : image.clone();
+    int rows = markers.rows;
+    int cols = markers.cols;
+    links_.resize((size_t)rows * cols);
+
+    // Draw a pixel-wide border of watershed lines
+    int* labels = markers.ptr<int>();
+    for (int column_index = 0; column_index < cols; ++column_index)
+    {
+        labels[column_index] = WATERSHED_LINE;
+        labels[(rows - 1) * cols + column_index] = WATERSHED_LINE;
+    }
+    for (int row_index = 0; row_index < rows; ++row_index)
+    {
+        labels[row_index * cols] = WATERSHED_LINE;
+        labels[row_index * cols + cols - 1] = WATERSHED_LINE;
+    }
+    if (rows < 3 || cols < 3)
+    {
+        return;
+    }
+    cv::Rect interior(1, 1, cols - 2, rows - 2);
+
+    // Every strip has to be taller than the bands around its seams
+    int number_of_tiles = std::min(number_of_tiles_, std::max(rows / (2 * seam_band_), 1));
+    if (number_of_tiles == 1)
+    {
+        flood(source, markers, interior, 0, rows * cols, true);
+        return;
+    }
+
+    // Keep the seeds around the seams, they are restored before the seams are reflooded
+    std::vector<cv::Range> bands;
+    std::vector<cv::Mat> band_seeds;
+    for (int tile_index = 1; tile_index < number_of_tiles; ++tile_index)
+    {
+        int seam_row = rows * tile_index / number_of_tiles;
+        cv::Range band(std::max(seam_row - seam_band_, 1), std::min(seam_row + seam_band_, rows - 1));
+        bands.push_back(band);
+        band_seeds.push_back(markers.rowRange(band.start, band.end).clone());
+    }
+
+    // Flood the strips independently, no strip reads or writes the rows of another one
+    cv::parallel_for_(cv::Range(0, number_of_tiles), [&](const cv::Range& range) {
+        for (int tile_index = range.start; tile_index < range.end; ++tile_index)
+        {
+            int row_begin = rows * tile_index / number_of_tiles;
+            int row_end = rows * (tile_index + 1) / number_of_tiles;
+            cv::Rect strip = interior & cv::Rect(0, row_begin, cols, row_end - row_begin);
+            if (!strip.empty())
+            {
+                flood(source, markers, strip, row_begin * cols, row_end * cols, true);
+            }
+        }
+    });
+
+    // Merge the strips by clearing the labels around the seams and flooding them again from both sides
+    for (size_t band_index = 0; band_index < bands.size(); ++band_index)
+    {
+        for (int row_index = bands[band_index].start; row_index < bands[band_index].end; ++row_index)
+        {
+            const int* seed_row = band_seeds[band_index].ptr<int>(row_index - bands[band_index].start);
+            int* label_row = markers.ptr<int>(row_index);
+            for (int column_index = 1; column_index < cols - 1; ++column_index)
+            {
+                label_row[column_index] = std::max(seed_row[column_index], 0);
+            }
+        }
+    }
+    reflood(source, markers, interior);
+}
+
+void Watershed::reflood(const cv::Mat& image, cv::Mat& markers, const cv::Rect& region)
+{
+    CVBASIC_SCOPED_TIMER("watershed_reflood");
+    CV_Assert(image.type() == CV_8UC3 && markers.type() == CV_32SC1);
+    CV_Assert(image.size() == markers.size() && markers.isContinuous());
+    cv::Mat source = image.isContinuous() ? image : image.clone();
+    cv::Rect interior = cv::Rect(1, 1, markers.cols - 2, markers.rows - 2) & region;
+    if (interior.empty())
+    {
+        return;
+    }
+    links_.resize((size_t)markers.rows * markers.cols);
+    flood(source, markers, interior, 0, markers.rows * markers.cols, false);
+}
+
+void Watershed::flood(const cv::Mat& image, cv::Mat& markers, const cv::Rect& region,
+                      const int& offset_begin, const int& offset_end, const bool& reset_negative)
+{
+    CVBASIC_SCOPED_TIMER("watershed_flood");
+    CVBASIC_COUNT(PIXELS_PROCESSED, (uint64_t)region.area());
+    const uchar* pixels = image.ptr<uchar>();
+    int* labels = markers.ptr<int>();
+    int cols = markers.cols;
+    BucketQueue queue(links_.data());
+
+    // Put the unlabelled pixels next to a label into the queue, keyed on the smallest difference to those labels
+    for (int row_index = region.y; row_index < region.y + region.height; ++row_index)
+    {
+        int row_offset = row_index * cols;
+        bool has_top = row_offset - cols >= offset_begin;
+        bool has_bottom = row_offset + cols < offset_end;
+        for (int column_index = region.x; column_index < region.x + region.width; ++column_index)
+        {
+            int offset = row_offset + column_index;
+            int* label = labels + offset;
+            if (reset_negative && *label < 0)
+            {
+                *label = 0;
+            }
+            if (*label != 0)
+            {
+                continue;
+            }
+            const uchar* pixel = pixels + 3 * offset;
+            int priority = BucketQueue::NUMBER_OF_BUCKETS;
+            if (label[-1] > 0)
+            {
+                priority = std::min(priority, get_difference(pixel, pixel - 3));
+            }
+            if (label[1] > 0)
+            {
+                priority = std::min(priority, get_difference(pixel, pixel + 3));
+            }
+            if (has_top && label[-cols] > 0)
+            {
+                priority = std::min(priority, get_difference(pixel, pixel - 3 * cols));
+            }
+            if (has_bottom && label[cols] > 0)
+            {
+                priority = std::min(priority, get_difference(pixel, pixel + 3 * cols));
+            }
+            if (priority < BucketQueue::NUMBER_OF_BUCKETS)
+            {
+                queue.push(priority, offset);
+                *label = IN_QUEUE;
+            }
+        }
+    }
+
+    // Flood the basins in the order of increasing priority
+    int offset;
+    while (queue.pop(offset))
+    {
+        int* label = labels + offset;
+        const uchar* pixel = pixels + 3 * offset;
+        bool has_top = offset - cols >= offset_begin;
+        bool has_bottom = offset + cols < offset_end;
+
+        // The pixel takes the label of its labelled neighbours, or becomes a watershed line if they disagree
+        int new_label = 0;
+        int neighbours[4] = {label[-1], label[1], has_top ? label[-cols] : 0, has_bottom ? label[cols] : 0};
+        for (int i = 0; i < 4; ++i)
+        {
+            if (neighbours[i] > 0)
+            {
+                if (new_label == 0)
+                {
+                    new_label = neighbours[i];
+                }
+                else if (neighbours[i] != new_label)
+                {
+                    new_label = WATERSHED_LINE;
+                }
+            }
+        }
+        *label = new_label;
+        if (new_label == WATERSHED_LINE)
+        {
+            continue;
+        }
+
+        // Put the unlabelled neighbours into the queue
+        if (label[-1] == 0)
+        {
+            queue.push(get_difference(pixel, pixel - 3), offset - 1);
+            label[-1] = IN_QUEUE;
+        }
+        if (label[1] == 0)
+        {
+            queue.push(get_difference(pixel, pixel + 3), offset + 1);
+            label[1] = IN_QUEUE;
+        }
+        if (has_top && label[-cols] == 0)
+        {
+            queue.push(get_difference(pixel, pixel - 3 * cols), offset - cols);
+            label[-cols] = IN_QUEUE;
+        }
+        if (has_bottom && label[cols] == 0)
+        {
+            queue.push(get_difference(pixel, pixel + 3 * cols), offset + cols);
+            label[cols] = IN_QUEUE;
+        }
+    }
+}
@@ -0,0 +1,158 @@
+/**
+ * @file watershed_benchmark.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief Compare the native watershed transform with cv::watershed on the sample images.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "buffer_pool/buffer_pool.hpp"
+#include "image_segmentation/dataset_loader.hpp"
+#include "image_segmentation/watershed.hpp"
+#include "instrumentation/instrumentation.hpp"
+
+/**
+ * @brief The number of runs per method, the fastest one is reported.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const int NUMBER_OF_RUNS = 5;
+
+/**
+ * @brief Run a segmentation several times on copies of the seeds and keep the fastest run.
+ * 
+ * @param[in] seeds The initial markers.
+ * @param[out] markers The segmented markers of the last run.
+ * @param[in] segment The segmentation function.
+ * @return The fastest run time in milliseconds.
+ * @since 0.0.2
+ */
+template <typename Function>
+double time_segmentation(const cv::Mat& seeds, cv::Mat& markers, Function segment)
+{
+    double best_time = 0;
+    for (int run_index = 0; run_index < NUMBER_OF_RUNS; ++run_index)
+    {
+        seeds.copyTo(markers);
+        int64 start = cv::getTickCount();
+        segment(markers);
+        double time = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+        if (run_index == 0 || time < best_time)
+        {
+            best_time = time;
+        }
+    }
+    return best_time;
+}
+
+/**
+ * @brief The main function.
+ * 
+ * @param[in] argc The argument count.
+ * @param[in] argv The argument vector.
+ * @return The status value.
+ * @since 0.0.2
+ */
+int main(int argc, char** argv)
+{
+    start_instrumentation();
+    install_buffer_pool();
+
+    if (argc > 3)
+    {
+        std::cout << "To run the watershed benchmark, type ./watershed_benchmark [<scale> [<number_of_tiles>]]"
+                  << std::endl;
+        return 1;
+    }
+    float scale = argc > 1 ? std::stof(argv[1]) : 1;
+    int number_of_tiles = argc > 2 ? std::stoi(argv[2]) : std::max(cv::getNumThreads(), 2);
+    if (scale <= 0 || number_of_tiles <= 0)
+    {
+        std::cout << "The scale and the number of tiles have to be greater than 0" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> img_paths;
+    if (!list_directory("sample_images/", img_paths))
+    {
+        std::cout << "Directory not found." << std::endl;
+        return 1;
+    }
+
+    // A half, a quarter or an eighth of the size is decoded directly at that size
+    int reduction = 1;
+    if (scale < 1 && (1 / scale == 2 || 1 / scale == 4 || 1 / scale == 8))
+    {
+        reduction = cvRound(1 / scale);
+    }
+
+    Watershed sequential_watershed;
+    Watershed tiled_watershed(number_of_tiles);
+    DatasetLoader loader(img_paths, cv::IMREAD_COLOR, reduction);
+    DatasetImage sample;
+    while (loader.next(sample))
+    {
+        cv::Mat image = sample.image;
+        if (scale != 1 && reduction == 1)
+        {
+            cv::resize(image, image, cv::Size(), scale, scale, cv::INTER_LINEAR);
+        }
+
+        // Seed a marker every 50 pixels, like the initial markers of the watershed segmentation
+        cv::Mat seeds = cv::Mat::zeros(image.size(), CV_32SC1);
+        int number_of_seeds = 0;
+        for (int i = 0; i < seeds.rows; i += 50)
+        {
+            for (int j = 0; j < seeds.cols; j += 50)
+            {
+                seeds.at<int>(i, j) = ++number_of_seeds;
+            }
+        }
+
+        cv::Mat reference, sequential, tiled;
+        double reference_time = time_segmentation(seeds, reference, [&](cv::Mat& markers) {
+            cv::watershed(image, markers);
+        });
+        double sequential_time = time_segmentation(seeds, sequential, [&](cv::Mat& markers) {
+            sequential_watershed.segment(image, markers);
+        });
+        double tiled_time = time_segmentation(seeds, tiled, [&](cv::Mat& markers) {
+            tiled_watershed.segment(image, markers);
+        });
+
+        int sequential_mismatches = cv::countNonZero(reference != sequential);
+        int tiled_mismatches = cv::countNonZero(reference != tiled);
+        double number_of_pixels = (double)image.total();
+        std::ios::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << sample.path << " (" << image.cols << "x" << image.rows << ", " << number_of_seeds << " seeds)\n";
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "    cv::watershed: " << std::setw(8) << reference_time << " ms\n";
+        std::cout << "    sequential:    " << std::setw(8) << sequential_time << " ms, " << std::setprecision(2)
+                  << reference_time / sequential_time << "x, " << sequential_mismatches << " mismatches\n";
+        std::cout << "    " << std::setw(2) << number_of_tiles << " tiles:      " << std::setprecision(3) << std::setw(8)
+                  << tiled_time << " ms, " << std::setprecision(2) << reference_time / tiled_time << "x, "
+                  << std::setprecision(3) << 100.0 * (number_of_pixels - tiled_mismatches) / number_of_pixels
+                  << "% agreement" << std::endl;
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+    }
+    for (const std::string& failure : loader.failures())
+    {
+        std::cout << failure << ": cannot be read" << std::endl;
+    }
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("watershed_benchmark");
+    return 0;
+}
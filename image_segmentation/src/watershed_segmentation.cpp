@@ -1,48 +1,70 @@
-#include <dirent.h>
+#include <cstring>
 #include <iostream>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include "buffer_pool/buffer_pool.hpp"
+#include "image_segmentation/dataset_loader.hpp"
+#include "image_segmentation/incremental_watershed.hpp"
+#include "image_segmentation/segmentation_output.hpp"
+#include "image_segmentation/watershed.hpp"
+#include "instrumentation/instrumentation.hpp"
+
+bool incremental = true;
+Watershed watershed;
+IncrementalWatershed incrementalWatershed;
+std::vector<cv::Vec3b> labelColors;
 cv::Mat orgImg, appliedImg, normImg, outImg;
 std::vector<std::vector<cv::Point>> vales;
 void CallBackFunc(int event, int x, int y, int flags, void* userdata);
+void updateIncrementally(const std::vector<cv::Point>& vale);
 
-int main()
+int main(int argc, char** argv)
 {
-    std::string dirName = "sample_images/";
-    DIR* pDir;
-    pDir = opendir(dirName.c_str());
-    if (pDir == NULL)
+    start_instrumentation();
+    install_buffer_pool();
+
+    bool tiled = false;
+    for (int i = 1; i < argc; i++)
     {
-        std::cout << "Directory not found." << std::endl;
-        return 1;
+        if (strcmp(argv[i], "--full") == 0)
+        {
+            incremental = false;
+        }
+        else if (strcmp(argv[i], "--tiled") == 0)
+        {
+            tiled = true;
+        }
+        else
+        {
+            std::cout << "To run the watershed segmentation, type ./watershed_segmentation [--full] [--tiled]" << std::endl;
+            return 1;
+        }
+    }
+
+    // The tiled mode is faster but may differ from cv::watershed close to the seams of the strips
+    if (tiled)
+    {
+        watershed = Watershed(cv::getNumThreads());
+        incrementalWatershed = IncrementalWatershed(cv::getNumThreads());
     }
 
-    struct dirent* pDirent;
     std::vector<std::string> img_paths;
-    while ((pDirent = readdir(pDir)) != NULL)
+    if (!list_directory("sample_images/", img_paths))
     {
-        if (strcmp(pDirent->d_name, ".") == 0 || strcmp(pDirent->d_name, "..") == 0)
-        {
-            continue;
-        }
-        std::string imgPath = dirName;
-        imgPath.append(pDirent->d_name);
-        img_paths.push_back(imgPath);
+        std::cout << "Directory not found." << std::endl;
+        return 1;
     }
-    closedir(pDir);
 
-    std::sort(img_paths.begin(), img_paths.end());
-    for (size_t idx = 0; idx < img_paths.size(); idx++)
+    // The next images are decoded while the current one is segmented
+    DatasetLoader loader(img_paths);
+    DatasetImage sample;
+    while (loader.next(sample))
     {
-        std::cout << img_paths[idx] << std::endl;
-        orgImg = cv::imread(img_paths[idx], 1);
-        if (orgImg.empty())
-        {
-            break;
-        }
+        std::cout << sample.path << std::endl;
+        orgImg = sample.image;
 
         appliedImg = orgImg.clone();
         normImg = cv::Mat::zeros(orgImg.size(), CV_8UC1);
@@ -56,6 +78,24 @@ int main()
         }
 
         outImg = cv::Mat::zeros(orgImg.size(), CV_8UC3);
+        vales.clear();
+        if (incremental)
+        {
+            // Every initial marker is a seed of its own, later scribbles only update the basins they touch
+            cv::Mat seeds = cv::Mat::zeros(orgImg.size(), CV_32SC1);
+            int noSeeds = 0;
+            for (int i = 0; i < seeds.rows; i += 50)
+            {
+                for (int j = 0; j < seeds.cols; j += 50)
+                {
+                    seeds.at<int>(i, j) = ++noSeeds;
+                }
+            }
+            incrementalWatershed.reset(orgImg, seeds);
+
+            labelColors = make_label_colors(noSeeds);
+            color_labels(incrementalWatershed.labels(), labelColors, outImg);
+        }
         cv::namedWindow("appliedImg", 1);
         cv::imshow("appliedImg", appliedImg);
         cv::imshow("outImg", outImg);
@@ -63,7 +103,13 @@ int main()
 
         cv::waitKey();
     }
+    for (const std::string& failure : loader.failures())
+    {
+        std::cout << failure << ": cannot be read, skipped" << std::endl;
+    }
 
+    write_buffer_pool_statistics(std::cout);
+    report_instrumentation("watershed_segmentation");
     return 0;
 }
 
@@ -95,7 +141,12 @@ void CallBackFunc(int event, int x, int y, int flags, void* userdata)
         }
     }
 
-    if (event == cv::EVENT_LBUTTONUP)
+    if (event == cv::EVENT_LBUTTONUP && incremental && vales.size() > 0)
+    {
+        updateIncrementally(vales[vales.size() - 1]);
+        cv::imshow("outImg", outImg);
+    }
+    else if (event == cv::EVENT_LBUTTONUP)
     {
         std::vector<std::vector<cv::Point>> contours;
         std::vector<cv::Vec4i> hierarchy;
@@ -109,35 +160,55 @@ void CallBackFunc(int event, int x, int y, int flags, void* userdata)
             cv::drawContours(markers, contours, i, cv::Scalar::all(i + 1), -1);
         }
 
-        cv::watershed(orgImg, markers);
-        std::vector<cv::Vec3b> colors;
-        for (int i = 0; i < noObjects; i++)
-        {
-            int b = cv::theRNG().uniform(0, 255);
-            int g = cv::theRNG().uniform(0, 255);
-            int r = cv::theRNG().uniform(0, 255);
-
-            colors.push_back(cv::Vec3b((uchar)b, (uchar)g, (uchar)r));
-        }
-
-        for (int i = 0; i < markers.rows; i++)
-        {
-            for (int j = 0; j < markers.cols; j++)
-            {
-                int index = markers.at<int>(i, j);
-                if (index > 0 && index <= noObjects)
-                {
-                    outImg.at<cv::Vec3b>(i, j) = colors[index - 1];
-                }
-                else
-                {
-                    outImg.at<cv::Vec3b>(i, j) = cv::Vec3b(0, 0, 0);
-                }
-            }
-        }
+        watershed.segment(orgImg, markers);
+        std::vector<cv::Vec3b> colors = make_label_colors(noObjects);
+        color_labels(markers, colors, outImg);
 
         cv::imshow("outImg", outImg);
     }
     cv::imshow("normImg", normImg);
     cv::imshow("appliedImg", appliedImg);
 }
+
+void updateIncrementally(const std::vector<cv::Point>& vale)
+{
+    int64 start = cv::getTickCount();
+
+    // Rasterize the scribble the same way it is drawn into normImg
+    cv::Rect bounds = cv::boundingRect(vale);
+    bounds = cv::Rect(bounds.x - 1, bounds.y - 1, bounds.width + 2, bounds.height + 2);
+    cv::Mat scribbleImg = cv::Mat::zeros(bounds.size(), CV_8UC1);
+    if (vale.size() == 1)
+    {
+        cv::circle(scribbleImg, vale[0] - bounds.tl(), 1, 255, 1);
+    }
+    for (size_t i = 1; i < vale.size(); i++)
+    {
+        cv::line(scribbleImg, vale[i - 1] - bounds.tl(), vale[i] - bounds.tl(), 255, 1);
+    }
+
+    // Fill a closed scribble like the contours of the full segmentation, so its inside is one region
+    std::vector<std::vector<cv::Point>> contours;
+    cv::Mat contoursImg = scribbleImg.clone();
+    cv::findContours(contoursImg, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
+    cv::drawContours(scribbleImg, contours, -1, 255, -1);
+    std::vector<cv::Point> scribble;
+    cv::findNonZero(scribbleImg, scribble);
+    for (size_t i = 0; i < scribble.size(); i++)
+    {
+        scribble[i] += bounds.tl();
+    }
+
+    // Flood the affected basins again and recolor only the pixels that changed
+    std::vector<int> changedPixels;
+    int label = incrementalWatershed.add_scribble(scribble, changedPixels);
+    if ((int)labelColors.size() <= label)
+    {
+        std::vector<cv::Vec3b> newColors = make_label_colors(label + 1 - labelColors.size());
+        labelColors.insert(labelColors.end(), newColors.begin() + 1, newColors.end());
+    }
+    color_labels(incrementalWatershed.labels(), labelColors, changedPixels, outImg);
+
+    double time = (cv::getTickCount() - start) * 1000.0 / cv::getTickFrequency();
+    std::cout << "Updated " << changedPixels.size() << " pixels in " << time << " ms" << std::endl;
+}
@@ -0,0 +1,171 @@
+/**
+ * @file instrumentation.hpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The timers of the stages and the counters of the work, exported as a Chrome trace and a text summary.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#ifndef INSTRUMENTATION_INSTRUMENTATION_HPP
+#define INSTRUMENTATION_INSTRUMENTATION_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * @brief The counters of the work done by the stages.
+ * 
+ * @since 0.0.2
+ * 
+ */
+enum Counter
+{
+    PIXELS_PROCESSED,  //!< The pixels read by the stages.
+    VOTES_CAST,        //!< The theta bins voted for in the Hough accumulators.
+    ALLOCATIONS,       //!< The cv::Mat buffers allocated.
+    NUMBER_OF_COUNTERS //!< The number of counters.
+};
+
+#ifdef CVBASIC_INSTRUMENTATION
+
+/**
+ * @brief A class to time a stage from its construction to its destruction.
+ * 
+ * Every thread records its own stages, so a timer only takes the lock of its thread, which is only contended while
+ * the results are exported.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class ScopedTimer
+{
+private:
+    const char* name_; //!< The name of the stage, a string literal.
+    int64_t start_;    //!< The start time in nanoseconds since the start of the process.
+
+public:
+    /**
+     * @brief Construct a new ScopedTimer object and start timing.
+     * 
+     * @param[in] name The name of the stage, a string literal.
+     * @since 0.0.2
+     */
+    explicit ScopedTimer(const char* name);
+
+    /**
+     * @brief Destroy the ScopedTimer object and record the stage.
+     * 
+     * @since 0.0.2
+     * 
+     */
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+/**
+ * @brief Add to a counter of the calling thread, without a lock.
+ * 
+ * @param[in] counter The counter.
+ * @param[in] value The value to add.
+ * @since 0.0.2
+ */
+void add_count(const Counter& counter, const uint64_t& value);
+
+/**
+ * @brief Get the total of a counter over every thread.
+ * 
+ * @param[in] counter The counter.
+ * @return The total of the counter.
+ * @since 0.0.2
+ */
+uint64_t get_count(const Counter& counter);
+
+/**
+ * @brief Start counting the cv::Mat allocations on top of the current default allocator of OpenCV.
+ * 
+ * Every tool calls it first in its main function, so that the stages and the allocations are recorded from the
+ * start. It does nothing when the instrumentation is compiled out.
+ * 
+ * @since 0.0.2
+ * 
+ */
+void start_instrumentation();
+
+/**
+ * @brief Clear the recorded stages and the counters, while no stage is running.
+ * 
+ * @since 0.0.2
+ * 
+ */
+void reset_instrumentation();
+
+/**
+ * @brief Write the recorded stages and the counters in the Chrome trace event format.
+ * 
+ * The trace can be opened in chrome://tracing or https://ui.perfetto.dev.
+ * 
+ * @param[in,out] stream The output stream.
+ * @since 0.0.2
+ */
+void write_trace(std::ostream& stream);
+
+/**
+ * @brief Write the calls and the times of every stage and the counters as a text table.
+ * 
+ * @param[in,out] stream The output stream.
+ * @since 0.0.2
+ */
+void write_summary(std::ostream& stream);
+
+/**
+ * @brief Print the summary and write the trace to <tool_name>_trace.json, at the end of a tool.
+ * 
+ * @param[in] tool_name The name of the tool.
+ * @since 0.0.2
+ */
+void report_instrumentation(const std::string& tool_name);
+
+#define CVBASIC_CONCATENATE_(prefix, suffix) prefix##suffix
+#define CVBASIC_CONCATENATE(prefix, suffix) CVBASIC_CONCATENATE_(prefix, suffix)
+
+/**
+ * @brief Time the rest of the enclosing scope as a stage.
+ * 
+ * @since 0.0.2
+ * 
+ */
+#define CVBASIC_SCOPED_TIMER(name) ScopedTimer CVBASIC_CONCATENATE(scoped_timer_, __LINE__)(name)
+
+/**
+ * @brief Add to a counter of the calling thread.
+ * 
+ * @since 0.0.2
+ * 
+ */
+#define CVBASIC_COUNT(counter, value) add_count(counter, value)
+
+#else
+
+#define CVBASIC_SCOPED_TIMER(name) ((void)0)
+#define CVBASIC_COUNT(counter, value) ((void)sizeof(value))
+
+inline void start_instrumentation()
+{
+}
+
+inline void reset_instrumentation()
+{
+}
+
+inline void report_instrumentation(const std::string&)
+{
+}
+
+#endif
+
+#endif // INSTRUMENTATION_INSTRUMENTATION_HPP
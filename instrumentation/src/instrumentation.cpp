@@ -0,0 +1,402 @@
+/**
+ * @file instrumentation.cpp
+ * @author Nguyen Quang <nqoptik@gmail.com>
+ * @brief The timers of the stages and the counters of the work, exported as a Chrome trace and a text summary.
+ * @since 0.0.2
+ * 
+ * @copyright Copyright (c) 2015, Nguyen Quang, all rights reserved.
+ * 
+ */
+
+#include "instrumentation/instrumentation.hpp"
+
+#ifdef CVBASIC_INSTRUMENTATION
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/**
+ * @brief The maximum number of stages kept for the trace of every thread, the summary keeps counting the others.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const size_t MAX_EVENTS_PER_THREAD = 1 << 20;
+
+/**
+ * @brief The names of the counters.
+ * 
+ * @since 0.0.2
+ * 
+ */
+static const char* const COUNTER_NAMES[NUMBER_OF_COUNTERS] = {"pixels_processed", "votes_cast", "allocations"};
+
+/**
+ * @brief A stage recorded for the trace.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct TraceEvent
+{
+    const char* name;   //!< The name of the stage.
+    int64_t start;      //!< The start time in nanoseconds.
+    int64_t duration;   //!< The duration in nanoseconds.
+};
+
+/**
+ * @brief The calls and the times of a stage.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct StageStatistics
+{
+    const char* name;   //!< The name of the stage.
+    uint64_t calls;     //!< The number of calls.
+    int64_t total;      //!< The total time in nanoseconds.
+    int64_t minimum;    //!< The shortest call in nanoseconds.
+    int64_t maximum;    //!< The longest call in nanoseconds.
+};
+
+/**
+ * @brief The stages and the counters of one thread.
+ * 
+ * The counters are only written by their thread, the stages are guarded by a lock that only the exporters contend.
+ * 
+ * @since 0.0.2
+ * 
+ */
+struct ThreadRecord
+{
+    int index;                                            //!< The index of the thread in the trace.
+    std::atomic<uint64_t> counts[NUMBER_OF_COUNTERS];     //!< The counters.
+    std::mutex mutex;                                     //!< The lock of the stages.
+    std::vector<TraceEvent> events;                       //!< The stages kept for the trace.
+    std::vector<StageStatistics> statistics;              //!< The statistics of every stage name.
+    uint64_t dropped_events;                              //!< The stages not kept for the trace.
+};
+
+static const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now(); //!< The time origin.
+static std::mutex registry_mutex;                                //!< The lock of the registry.
+static std::vector<std::shared_ptr<ThreadRecord>> thread_records; //!< The records of every thread that has run a stage.
+
+/**
+ * @brief Get the time since the start of the process.
+ * 
+ * @return The time in nanoseconds.
+ * @since 0.0.2
+ */
+static inline int64_t get_time()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+/**
+ * @brief Register a new thread record, it outlives its thread so the stages of finished threads are still exported.
+ * 
+ * @return The record.
+ * @since 0.0.2
+ */
+static std::shared_ptr<ThreadRecord> register_thread()
+{
+    std::shared_ptr<ThreadRecord> record = std::make_shared<ThreadRecord>();
+    for (int counter = 0; counter < NUMBER_OF_COUNTERS; ++counter)
+    {
+        record->counts[counter].store(0, std::memory_order_relaxed);
+    }
+    record->dropped_events = 0;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    record->index = (int)thread_records.size();
+    thread_records.push_back(record);
+    return record;
+}
+
+/**
+ * @brief Get the record of the calling thread.
+ * 
+ * @return The record, registered on the first call of the thread.
+ * @since 0.0.2
+ */
+static ThreadRecord& get_thread_record()
+{
+    thread_local std::shared_ptr<ThreadRecord> record = register_thread();
+    return *record;
+}
+
+/**
+ * @brief Get a copy of the registry, so it is not locked while the records are read.
+ * 
+ * @return The records of every thread.
+ * @since 0.0.2
+ */
+static std::vector<std::shared_ptr<ThreadRecord>> get_thread_records()
+{
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return thread_records;
+}
+
+ScopedTimer::ScopedTimer(const char* name)
+    : name_(name),
+      start_(get_time())
+{
+}
+
+ScopedTimer::~ScopedTimer()
+{
+    int64_t duration = get_time() - start_;
+    ThreadRecord& record = get_thread_record();
+    std::lock_guard<std::mutex> lock(record.mutex);
+    if (record.events.size() < MAX_EVENTS_PER_THREAD)
+    {
+        record.events.push_back({name_, start_, duration});
+    }
+    else
+    {
+        ++record.dropped_events;
+    }
+
+    // A thread only runs a few stages, so a linear search is enough
+    for (StageStatistics& statistics : record.statistics)
+    {
+        if (statistics.name == name_ || std::strcmp(statistics.name, name_) == 0)
+        {
+            ++statistics.calls;
+            statistics.total += duration;
+            statistics.minimum = std::min(statistics.minimum, duration);
+            statistics.maximum = std::max(statistics.maximum, duration);
+            return;
+        }
+    }
+    record.statistics.push_back({name_, 1, duration, duration, duration});
+}
+
+void add_count(const Counter& counter, const uint64_t& value)
+{
+    get_thread_record().counts[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t get_count(const Counter& counter)
+{
+    uint64_t count = 0;
+    for (const std::shared_ptr<ThreadRecord>& record : get_thread_records())
+    {
+        count += record->counts[counter].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+#if CV_VERSION_MAJOR >= 3
+
+#if CV_VERSION_MAJOR >= 4
+typedef cv::AccessFlag AccessFlags;
+#else
+typedef int AccessFlags;
+#endif
+
+/**
+ * @brief A cv::Mat allocator that counts the buffers and delegates them to another allocator.
+ * 
+ * The buffers keep the other allocator as their allocator, so they are released without going through this one.
+ * 
+ * @since 0.0.2
+ * 
+ */
+class CountingMatAllocator : public cv::MatAllocator
+{
+private:
+    cv::MatAllocator* allocator_; //!< The allocator of the buffers.
+
+public:
+    explicit CountingMatAllocator(cv::MatAllocator* allocator)
+        : allocator_(allocator)
+    {
+    }
+
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                           AccessFlags flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        if (data == nullptr)
+        {
+            add_count(ALLOCATIONS, 1);
+        }
+        return allocator_->allocate(dims, sizes, type, data, step, flags, usage_flags);
+    }
+
+    bool allocate(cv::UMatData* data, AccessFlags flags, cv::UMatUsageFlags usage_flags) const override
+    {
+        return allocator_->allocate(data, flags, usage_flags);
+    }
+
+    void deallocate(cv::UMatData* data) const override
+    {
+        allocator_->deallocate(data);
+    }
+};
+
+#endif
+
+void start_instrumentation()
+{
+#if CV_VERSION_MAJOR >= 3
+    static CountingMatAllocator allocator(cv::Mat::getDefaultAllocator());
+    cv::Mat::setDefaultAllocator(&allocator);
+#endif
+    get_thread_record();
+}
+
+void reset_instrumentation()
+{
+    for (const std::shared_ptr<ThreadRecord>& record : get_thread_records())
+    {
+        for (int counter = 0; counter < NUMBER_OF_COUNTERS; ++counter)
+        {
+            record->counts[counter].store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(record->mutex);
+        record->events.clear();
+        record->statistics.clear();
+        record->dropped_events = 0;
+    }
+}
+
+/**
+ * @brief Write a string as a JSON string.
+ * 
+ * @param[in,out] stream The output stream.
+ * @param[in] text The string.
+ * @since 0.0.2
+ */
+static void write_json_string(std::ostream& stream, const char* text)
+{
+    stream << '"';
+    for (const char* character = text; *character != '\0'; ++character)
+    {
+        if (*character == '"' || *character == '\\')
+        {
+            stream << '\\';
+        }
+        stream << *character;
+    }
+    stream << '"';
+}
+
+void write_trace(std::ostream& stream)
+{
+    // The times of the trace events are in microseconds
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"traceEvents\":[";
+    bool first = true;
+    int64_t end_time = 0;
+    for (const std::shared_ptr<ThreadRecord>& record : get_thread_records())
+    {
+        stream << (first ? "\n" : ",\n");
+        first = false;
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << record->index
+               << ",\"args\":{\"name\":\"thread " << record->index << "\"}}";
+        std::lock_guard<std::mutex> lock(record->mutex);
+        for (const TraceEvent& event : record->events)
+        {
+            stream << ",\n{\"name\":";
+            write_json_string(stream, event.name);
+            stream << ",\"cat\":\"cvbasic\",\"ph\":\"X\",\"pid\":1,\"tid\":" << record->index
+                   << ",\"ts\":" << event.start / 1000.0 << ",\"dur\":" << event.duration / 1000.0 << "}";
+            end_time = std::max(end_time, event.start + event.duration);
+        }
+    }
+
+    // The counters are only known in total, so they are shown once at the end of the trace
+    for (int counter = 0; counter < NUMBER_OF_COUNTERS; ++counter)
+    {
+        stream << (first ? "\n" : ",\n");
+        first = false;
+        stream << "{\"name\":\"" << COUNTER_NAMES[counter] << "\",\"ph\":\"C\",\"pid\":1,\"ts\":" << end_time / 1000.0
+               << ",\"args\":{\"value\":" << get_count((Counter)counter) << "}}";
+    }
+    stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+void write_summary(std::ostream& stream)
+{
+    // Merge the stages of every thread by name, in the order they are first seen
+    std::vector<StageStatistics> stages;
+    std::map<std::string, size_t> stage_indices;
+    uint64_t dropped_events = 0;
+    for (const std::shared_ptr<ThreadRecord>& record : get_thread_records())
+    {
+        std::lock_guard<std::mutex> lock(record->mutex);
+        for (const StageStatistics& statistics : record->statistics)
+        {
+            std::map<std::string, size_t>::iterator it = stage_indices.find(statistics.name);
+            if (it == stage_indices.end())
+            {
+                stage_indices[statistics.name] = stages.size();
+                stages.push_back(statistics);
+                continue;
+            }
+            StageStatistics& stage = stages[it->second];
+            stage.calls += statistics.calls;
+            stage.total += statistics.total;
+            stage.minimum = std::min(stage.minimum, statistics.minimum);
+            stage.maximum = std::max(stage.maximum, statistics.maximum);
+        }
+        dropped_events += record->dropped_events;
+    }
+
+    std::ios::fmtflags flags = stream.flags();
+    std::streamsize precision = stream.precision();
+    stream << std::left << std::setw(32) << "Stage" << std::right << std::setw(10) << "Calls" << std::setw(14)
+           << "Total (ms)" << std::setw(14) << "Mean (ms)" << std::setw(14) << "Min (ms)" << std::setw(14)
+           << "Max (ms)" << "\n";
+    stream << std::fixed << std::setprecision(3);
+    for (const StageStatistics& stage : stages)
+    {
+        stream << std::left << std::setw(32) << stage.name << std::right << std::setw(10) << stage.calls
+               << std::setw(14) << stage.total / 1e6 << std::setw(14) << stage.total / 1e6 / stage.calls
+               << std::setw(14) << stage.minimum / 1e6 << std::setw(14) << stage.maximum / 1e6 << "\n";
+    }
+    stream << "\n" << std::left << std::setw(32) << "Counter" << std::right << std::setw(20) << "Value" << "\n";
+    for (int counter = 0; counter < NUMBER_OF_COUNTERS; ++counter)
+    {
+        stream << std::left << std::setw(32) << COUNTER_NAMES[counter] << std::right << std::setw(20)
+               << get_count((Counter)counter) << "\n";
+    }
+    if (dropped_events > 0)
+    {
+        stream << "\n" << dropped_events << " stages are in the summary but not in the trace.\n";
+    }
+    stream.flags(flags);
+    stream.precision(precision);
+}
+
+void report_instrumentation(const std::string& tool_name)
+{
+    std::cout << "\n";
+    write_summary(std::cout);
+    std::string path = tool_name + "_trace.json";
+    std::ofstream stream(path.c_str());
+    if (!stream)
+    {
+        std::cout << "The trace cannot be written to " << path << ".\n";
+        return;
+    }
+    write_trace(stream);
+    std::cout << "The trace is written to " << path << ".\n";
+}
+
+#endif